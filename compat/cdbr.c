@@ -48,6 +48,15 @@
 #include <mi_vector_hash.h>
 #define SET_ERRNO(val) errno = (val)
 
+#if defined(__GNUC__)
+#define	CDBR_PREFETCH(addr)	__builtin_prefetch(addr)
+#else
+#define	CDBR_PREFETCH(addr)	(void)(addr)
+#endif
+
+/* Keys looked up together by cdbr_find_batch() */
+#define	CDBR_BATCH	16
+
 struct cdbr {
 	void (*unmap)(void *, void *, size_t);
 	void *cookie;
@@ -57,12 +66,21 @@ struct cdbr {
 	uint8_t *hash_base;
 	uint8_t *offset_base;
 	uint8_t *data_base;
+	uint8_t *fingerprint_base;
 
 	uint32_t data_size;
 	uint32_t entries;
 	uint32_t entries_index;
 	uint32_t seed;
 
+	/* Multipliers and shifts to divide by entries and entries_index */
+	uint32_t entries_m;
+	uint32_t entries_index_m;
+	uint8_t entries_s1;
+	uint8_t entries_s2;
+	uint8_t entries_index_s1;
+	uint8_t entries_index_s2;
+
 	uint8_t offset_size;
 	uint8_t index_size;
 };
@@ -119,12 +137,95 @@ le32dec(const uint8_t *buf)
 	    (uint32_t)buf[2] << 16 | (uint32_t)buf[3] << 24;
 }
 
+/*
+ * The hashes are reduced modulo entries_index and the sum of the index
+ * entries modulo entries. Both are fixed once the file is open, so
+ * divide by multiplying and shifting as described in
+ * "Division by Invariant Integers using Multiplication" by
+ * Torbjorn Granlund and Peter L. Montgomery.
+ */
+static void
+fast_divide32_prepare(uint32_t div, uint32_t *m, uint8_t *s1, uint8_t *s2)
+{
+	uint64_t mt;
+	int l;
+
+	for (l = 0; l < 32 && (div - 1) >> l != 0; ++l)
+		continue;
+	mt = (uint64_t)0x100000000ULL * ((1ULL << l) - div);
+	*m = (uint32_t)(mt / div + 1);
+	*s1 = l > 1 ? 1 : (uint8_t)l;
+	*s2 = l == 0 ? 0 : (uint8_t)(l - 1);
+}
+
+static inline uint32_t
+fast_remainder32(uint32_t v, uint32_t div, uint32_t m, uint8_t s1,
+    uint8_t s2)
+{
+	uint32_t t;
+
+	t = (uint32_t)(((uint64_t)v * m) >> 32);
+	return v - div * ((t + ((v - t) >> s1)) >> s2);
+}
+
+static inline uint32_t
+sum_index_1(const uint8_t *base, const uint32_t *hashes)
+{
+
+	return (uint32_t)base[hashes[0]] + base[hashes[1]] + base[hashes[2]];
+}
+
+static inline uint32_t
+le16dec(const uint8_t *buf)
+{
+	return (uint32_t)buf[0] | (uint32_t)buf[1] << 8;
+}
+
+static inline uint32_t
+sum_index_2(const uint8_t *base, const uint32_t *hashes)
+{
+
+	return le16dec(base + 2 * hashes[0]) + le16dec(base + 2 * hashes[1]) +
+	    le16dec(base + 2 * hashes[2]);
+}
+
+static inline uint32_t
+sum_index_4(const uint8_t *base, const uint32_t *hashes)
+{
+
+	return le32dec(base + 4 * hashes[0]) + le32dec(base + 4 * hashes[1]) +
+	    le32dec(base + 4 * hashes[2]);
+}
+
+static inline uint32_t
+get_offset_1(const uint8_t *base, uint32_t idx)
+{
+
+	return base[idx];
+}
+
+static inline uint32_t
+get_offset_2(const uint8_t *base, uint32_t idx)
+{
+
+	return le16dec(base + 2 * idx);
+}
+
+static inline uint32_t
+get_offset_4(const uint8_t *base, uint32_t idx)
+{
+
+	return le32dec(base + 4 * idx);
+}
+
 struct cdbr *
 cdbr_open_mem(void *base, size_t size, int flags,
     void (*unmap)(void *, void *, size_t), void *cookie)
 {
 	struct cdbr *cdbr;
 	uint8_t *buf = base;
+	size_t avail;
+
 	if (size < 40 || memcmp(buf, "NBCDB\n\0\001", 8)) {
 		SET_ERRNO(EINVAL);
 		return NULL;
@@ -153,6 +254,18 @@ cdbr_open_mem(void *base, size_t size, int flags,
 	else
 		cdbr->index_size = 4;
 
+	/* An empty index is refused by cdbr_find() before use. */
+	cdbr->entries_m = cdbr->entries_index_m = 0;
+	cdbr->entries_s1 = cdbr->entries_s2 = 0;
+	cdbr->entries_index_s1 = cdbr->entries_index_s2 = 0;
+	if (cdbr->entries != 0)
+		fast_divide32_prepare(cdbr->entries, &cdbr->entries_m,
+		    &cdbr->entries_s1, &cdbr->entries_s2);
+	if (cdbr->entries_index != 0)
+		fast_divide32_prepare(cdbr->entries_index,
+		    &cdbr->entries_index_m, &cdbr->entries_index_s1,
+		    &cdbr->entries_index_s2);
+
 	cdbr->mmap_base = base;
 	cdbr->mmap_size = size;
 
@@ -174,20 +287,15 @@ cdbr_open_mem(void *base, size_t size, int flags,
 		return NULL;
 	}
 
-	return cdbr;
-}
-
-static inline uint32_t
-get_uintX(const uint8_t *addr, uint32_t idx, int size)
-{
-	addr += idx * size;
+	/* The key fingerprints optionally follow the data. */
+	cdbr->fingerprint_base = NULL;
+	avail = (size_t)(cdbr->mmap_base + cdbr->mmap_size -
+	    (cdbr->data_base + cdbr->data_size));
+	if (avail >= 8 && (avail - 8) / 4 >= cdbr->entries &&
+	    memcmp(cdbr->data_base + cdbr->data_size, "NBCDBFP\001", 8) == 0)
+		cdbr->fingerprint_base = cdbr->data_base + cdbr->data_size + 8;
 
-	if (size == 4)
-		return le32dec(addr);
-	else if (size == 2)
-		return (uint32_t)addr[0] | (uint32_t)addr[1] << 8;
-	else
-		return *addr;
+	return cdbr;
 }
 
 uint32_t
@@ -207,8 +315,20 @@ cdbr_get(struct cdbr *cdbr, uint32_t idx, const void **data, size_t *data_len)
 		return -1;
 	}
 
-	start = get_uintX(cdbr->offset_base, idx, cdbr->offset_size);
-	end = get_uintX(cdbr->offset_base, idx + 1, cdbr->offset_size);
+	switch (cdbr->offset_size) {
+	case 1:
+		start = get_offset_1(cdbr->offset_base, idx);
+		end = get_offset_1(cdbr->offset_base, idx + 1);
+		break;
+	case 2:
+		start = get_offset_2(cdbr->offset_base, idx);
+		end = get_offset_2(cdbr->offset_base, idx + 1);
+		break;
+	default:
+		start = get_offset_4(cdbr->offset_base, idx);
+		end = get_offset_4(cdbr->offset_base, idx + 1);
+		break;
+	}
 
 	if (start > end) {
 		SET_ERRNO(EIO);
@@ -226,11 +346,77 @@ cdbr_get(struct cdbr *cdbr, uint32_t idx, const void **data, size_t *data_len)
 	return 0;
 }
 
+/*
+ * The fingerprint of a key is folded from its hash words as cdbw.c
+ * does. A stored fingerprint of zero means the entry can't be checked.
+ */
+static inline uint32_t
+fingerprint(const uint32_t hashes[3])
+{
+	uint32_t fp;
+
+	fp = hashes[0] ^ (hashes[1] << 11 | hashes[1] >> 21) ^
+	    (hashes[2] << 22 | hashes[2] >> 10);
+	return fp == 0 ? 1 : fp;
+}
+
+static inline void
+cdbr_reduce(struct cdbr *cdbr, uint32_t hashes[3])
+{
+	int i;
+
+	for (i = 0; i < 3; ++i)
+		hashes[i] = fast_remainder32(hashes[i], cdbr->entries_index,
+		    cdbr->entries_index_m, cdbr->entries_index_s1,
+		    cdbr->entries_index_s2);
+}
+
+static inline uint32_t
+cdbr_entry(struct cdbr *cdbr, const uint32_t hashes[3])
+{
+	uint32_t idx;
+
+	switch (cdbr->index_size) {
+	case 1:
+		idx = sum_index_1(cdbr->hash_base, hashes);
+		break;
+	case 2:
+		idx = sum_index_2(cdbr->hash_base, hashes);
+		break;
+	default:
+		idx = sum_index_4(cdbr->hash_base, hashes);
+		break;
+	}
+	return fast_remainder32(idx, cdbr->entries, cdbr->entries_m,
+	    cdbr->entries_s1, cdbr->entries_s2);
+}
+
 int
 cdbr_find(struct cdbr *cdbr, const void *key, size_t key_len,
     const void **data, size_t *data_len)
 {
-	uint32_t hashes[3], idx;
+	uint32_t hashes[3];
+
+	if (cdbr->entries_index == 0) {
+		SET_ERRNO(EINVAL);
+		return -1;
+	}
+
+	mi_vector_hash(key, key_len, cdbr->seed, hashes);
+	cdbr_reduce(cdbr, hashes);
+	return cdbr_get(cdbr, cdbr_entry(cdbr, hashes), data, data_len);
+}
+
+/*
+ * As cdbr_find(), but if the database has key fingerprints fail with
+ * ENOENT when that of the entry found doesn't match the key, so most
+ * keys not in the database are rejected without reading their entry.
+ */
+int
+cdbr_find_verified(struct cdbr *cdbr, const void *key, size_t key_len,
+    const void **data, size_t *data_len)
+{
+	uint32_t hashes[3], fp, idx, efp;
 
 	if (cdbr->entries_index == 0) {
 		SET_ERRNO(EINVAL);
@@ -238,16 +424,67 @@ cdbr_find(struct cdbr *cdbr, const void *key, size_t key_len,
 	}
 
 	mi_vector_hash(key, key_len, cdbr->seed, hashes);
+	fp = fingerprint(hashes);
+	cdbr_reduce(cdbr, hashes);
+	idx = cdbr_entry(cdbr, hashes);
+	if (cdbr->fingerprint_base != NULL && idx < cdbr->entries) {
+		efp = le32dec(cdbr->fingerprint_base + 4 * (size_t)idx);
+		if (efp != 0 && efp != fp) {
+			SET_ERRNO(ENOENT);
+			return -1;
+		}
+	}
+	return cdbr_get(cdbr, idx, data, data_len);
+}
 
-	hashes[0] %= cdbr->entries_index;
-	hashes[1] %= cdbr->entries_index;
-	hashes[2] %= cdbr->entries_index;
+/*
+ * Look up n keys at once. The keys are hashed a batch at a time and
+ * the index, offset and data of each batch are prefetched before they
+ * are read, so the cache misses of the lookups overlap.
+ * Returns -1 if any lookup failed, its data being set to NULL.
+ */
+int
+cdbr_find_batch(struct cdbr *cdbr, size_t n, const void * const *keys,
+    const size_t *key_lens, const void **data, size_t *data_lens)
+{
+	uint32_t hashes[CDBR_BATCH][3], idx[CDBR_BATCH];
+	size_t i, j, m;
+	int k, rv;
 
-	idx = get_uintX(cdbr->hash_base, hashes[0], cdbr->index_size);
-	idx += get_uintX(cdbr->hash_base, hashes[1], cdbr->index_size);
-	idx += get_uintX(cdbr->hash_base, hashes[2], cdbr->index_size);
+	if (cdbr->entries_index == 0) {
+		SET_ERRNO(EINVAL);
+		return -1;
+	}
 
-	return cdbr_get(cdbr, idx % cdbr->entries, data, data_len);
+	rv = 0;
+	for (i = 0; i < n; i += m) {
+		m = n - i < CDBR_BATCH ? n - i : CDBR_BATCH;
+		for (j = 0; j < m; ++j) {
+			mi_vector_hash(keys[i + j], key_lens[i + j],
+			    cdbr->seed, hashes[j]);
+			cdbr_reduce(cdbr, hashes[j]);
+			for (k = 0; k < 3; ++k)
+				CDBR_PREFETCH(cdbr->hash_base +
+				    hashes[j][k] * cdbr->index_size);
+		}
+		for (j = 0; j < m; ++j) {
+			idx[j] = cdbr_entry(cdbr, hashes[j]);
+			CDBR_PREFETCH(cdbr->offset_base +
+			    idx[j] * cdbr->offset_size);
+		}
+		for (j = 0; j < m; ++j) {
+			if (cdbr_get(cdbr, idx[j], &data[i + j],
+			    &data_lens[i + j]) == -1)
+			{
+				data[i + j] = NULL;
+				data_lens[i + j] = 0;
+				rv = -1;
+				continue;
+			}
+			CDBR_PREFETCH(data[i + j]);
+		}
+	}
+	return rv;
 }
 
 void
@@ -54,6 +54,10 @@ uint32_t	 cdbr_entries(struct cdbr *);
 int		 cdbr_get(struct cdbr *, uint32_t, const void **, size_t *);
 int		 cdbr_find(struct cdbr *, const void *, size_t,
     const void **, size_t *);
+int		 cdbr_find_verified(struct cdbr *, const void *, size_t,
+    const void **, size_t *);
+int		 cdbr_find_batch(struct cdbr *, size_t, const void * const *,
+    const size_t *, const void **, size_t *);
 void		 cdbr_close(struct cdbr *);
 
 #endif /* _CDBR_H */
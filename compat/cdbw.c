@@ -41,6 +41,9 @@
 #include <string.h>
 #include <unistd.h>
 #include <mi_vector_hash.h>
+#ifdef CDBW_THREADS
+#include <pthread.h>
+#endif
 
 struct key_hash {
 	SLIST_ENTRY(key_hash) link;
@@ -62,6 +65,8 @@ struct cdbw {
 	size_t hash_size;
 	struct key_hash_head *hash;
 	size_t key_counter;
+
+	int fingerprints;
 };
 
  /* Max. data counter that allows the index size to be 32bit. */
@@ -262,6 +267,17 @@ cdbw_stable_seeder(void)
 	return 0;
 }
 
+/*
+ * Also write a fingerprint of the key of each entry after the data,
+ * which cdbr_find_verified() checks to reject keys not in the database.
+ */
+void
+cdbw_set_fingerprints(struct cdbw *cdbw, int enable)
+{
+
+	cdbw->fingerprints = enable;
+}
+
 /*
  * For each vertex in the 3-graph, the incidence lists needs to be kept.
  * Avoid storing the full list by just XORing the indices of the still
@@ -297,10 +313,24 @@ struct state {
 	uint32_t *g;
 	char *visited;
 
+	/*
+	 * The keys are copied one after another in edge order so that
+	 * hashing them for each seed tried streams through memory.
+	 */
+	char *key_buf;
+	size_t *key_off;
+
 	struct vertex *vertices;
 	struct edge *edges;
 	uint32_t output_index;
 	uint32_t *output_order;
+
+	uint32_t *fingerprints;
+
+#ifdef CDBW_THREADS
+	pthread_mutex_t lock;
+	int failed;
+#endif
 };
 
 /*
@@ -334,45 +364,180 @@ remove_vertex(struct state *state, uint32_t v)
 	}
 }
 
+/*
+ * Copy the keys into a single buffer and give each edge its data index,
+ * neither of which depend on the seed.
+ */
 static int
-build_graph(struct cdbw *cdbw, struct state *state)
+gather_keys(struct cdbw *cdbw, struct state *state)
 {
 	struct key_hash_head *head;
 	struct key_hash *key_hash;
-	struct edge *e;
-	uint32_t hashes[3];
-	size_t i;
-	int j;
-
-	memset(state->vertices, 0, sizeof(*state->vertices) * state->entries);
+	size_t i, len;
+	uint32_t e;
 
-	e = state->edges;
+	len = 0;
+	for (i = 0; i < cdbw->hash_size; ++i) {
+		head = &cdbw->hash[i];
+		SLIST_FOREACH(key_hash, head, link)
+			len += key_hash->keylen;
+	}
+	state->key_buf = malloc(len == 0 ? 1 : len);
+	if (state->key_buf == NULL)
+		return -1;
 
+	e = 0;
+	len = 0;
 	for (i = 0; i < cdbw->hash_size; ++i) {
 		head = &cdbw->hash[i];
 		SLIST_FOREACH(key_hash, head, link) {
-			mi_vector_hash(key_hash->key, key_hash->keylen,
-			    state->seed, hashes);
+			memcpy(state->key_buf + len, key_hash->key,
+			    key_hash->keylen);
+			state->key_off[e] = len;
+			state->edges[e].idx = key_hash->idx;
+			len += key_hash->keylen;
+			++e;
+		}
+	}
+	state->key_off[e] = len;
+	return 0;
+}
 
-			for (j = 0; j < 3; ++j)
-				e->vertices[j] = hashes[j] % state->entries;
+/*
+ * Compute the vertices of the edges start to end for the current seed.
+ * Fail as soon as an edge is degenerate as the seed is then useless.
+ */
+static int
+hash_edges(struct state *state, uint32_t start, uint32_t end)
+{
+	struct edge *e;
+	uint32_t hashes[3], i;
+	int j;
 
-			if (e->vertices[0] == e->vertices[1])
-				return -1;
-			if (e->vertices[0] == e->vertices[2])
-				return -1;
-			if (e->vertices[1] == e->vertices[2])
-				return -1;
-			e->idx = key_hash->idx;
-			++e;
+	for (i = start; i < end; ++i) {
+		e = &state->edges[i];
+		mi_vector_hash(state->key_buf + state->key_off[i],
+		    state->key_off[i + 1] - state->key_off[i],
+		    state->seed, hashes);
+
+		for (j = 0; j < 3; ++j)
+			e->vertices[j] = hashes[j] % state->entries;
+
+		if (e->vertices[0] == e->vertices[1])
+			return -1;
+		if (e->vertices[0] == e->vertices[2])
+			return -1;
+		if (e->vertices[1] == e->vertices[2])
+			return -1;
+	}
+	return 0;
+}
+
+#ifdef CDBW_THREADS
+/*
+ * Large key sets are hashed in slices on several threads, the result
+ * being the same as hashing them in order. Each slice checks every
+ * SLICE_CHUNK keys whether another has found a degenerate edge.
+ */
+#define	THREAD_KEYS	65536
+#define	MAX_THREADS	16
+#define	SLICE_CHUNK	4096
+
+struct hash_slice {
+	pthread_t thread;
+	int started;
+	struct state *state;
+	uint32_t start, end;
+	int rv;
+};
+
+static void *
+hash_slice(void *arg)
+{
+	struct hash_slice *slice = arg;
+	struct state *state = slice->state;
+	uint32_t i, end;
+	int failed;
+
+	for (i = slice->start; i < slice->end; i = end) {
+		pthread_mutex_lock(&state->lock);
+		failed = state->failed;
+		pthread_mutex_unlock(&state->lock);
+		if (failed)
+			break;
+		end = slice->end - i > SLICE_CHUNK ?
+		    i + SLICE_CHUNK : slice->end;
+		if (hash_edges(state, i, end)) {
+			pthread_mutex_lock(&state->lock);
+			state->failed = 1;
+			pthread_mutex_unlock(&state->lock);
+			break;
 		}
 	}
+	slice->rv = i < slice->end ? -1 : 0;
+	return NULL;
+}
+
+static int
+hash_keys(struct state *state)
+{
+	struct hash_slice slices[MAX_THREADS];
+	long ncpu;
+	uint32_t n, i, step;
+	int rv;
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	n = state->keys / THREAD_KEYS;
+	if (ncpu > 0 && n > (uint32_t)ncpu)
+		n = (uint32_t)ncpu;
+	if (n > MAX_THREADS)
+		n = MAX_THREADS;
+	if (n <= 1 || pthread_mutex_init(&state->lock, NULL) != 0)
+		return hash_edges(state, 0, state->keys);
+
+	state->failed = 0;
+	step = state->keys / n;
+	for (i = 0; i < n; ++i) {
+		slices[i].state = state;
+		slices[i].start = i * step;
+		slices[i].end = i == n - 1 ? state->keys : (i + 1) * step;
+		slices[i].started = i != 0 && pthread_create(&slices[i].thread,
+		    NULL, hash_slice, &slices[i]) == 0;
+	}
+	/* Hash here the slices that no thread was started for. */
+	rv = 0;
+	for (i = 0; i < n; ++i) {
+		if (!slices[i].started)
+			hash_slice(&slices[i]);
+	}
+	for (i = 0; i < n; ++i) {
+		if (slices[i].started)
+			pthread_join(slices[i].thread, NULL);
+		if (slices[i].rv != 0)
+			rv = -1;
+	}
+	pthread_mutex_destroy(&state->lock);
+	return rv;
+}
+#else
+#define	hash_keys(state)	hash_edges((state), 0, (state)->keys)
+#endif
+
+static int
+build_graph(struct state *state)
+{
+	struct edge *e;
+	size_t i;
+	int j;
+
+	if (hash_keys(state))
+		return -1;
 
 	/*
 	 * Do the edge processing separately as there is a good chance
-	 * the degraded edge case above will happen; this avoid
-	 *unnecessary  work.
+	 * hash_keys() finds a degraded edge; this avoids unnecessary work.
 	 */
+	memset(state->vertices, 0, sizeof(*state->vertices) * state->entries);
 	for (i = 0; i < state->keys; ++i)
 		change_edge(state, 1, i);
 
@@ -422,6 +587,55 @@ assign_nodes(struct state *state)
 	}
 }
 
+/*
+ * The fingerprint of a key is folded from the hash words it was placed
+ * with, so cdbr needs no extra hashing to check it. It must match
+ * cdbr.c. Zero is kept for entries that can't be checked.
+ */
+static uint32_t
+fingerprint(const uint32_t hashes[3])
+{
+	uint32_t fp;
+
+	fp = hashes[0] ^ (hashes[1] << 11 | hashes[1] >> 21) ^
+	    (hashes[2] << 22 | hashes[2] >> 10);
+	return fp == 0 ? 1 : fp;
+}
+
+/*
+ * Fingerprint the key of each entry. Entries without a key or with
+ * several keys can't be checked and keep a zero fingerprint.
+ */
+static int
+compute_fingerprints(struct state *state)
+{
+	uint8_t *nkeys;
+	uint32_t hashes[3], i, idx;
+
+	state->fingerprints = calloc(state->data_entries,
+	    sizeof(*state->fingerprints));
+	nkeys = calloc(state->data_entries, 1);
+	if (state->fingerprints == NULL || nkeys == NULL) {
+		free(nkeys);
+		return -1;
+	}
+	for (i = 0; i < state->keys; ++i) {
+		idx = state->edges[i].idx;
+		if (nkeys[idx] == 2)
+			continue;
+		if (nkeys[idx]++ == 1) {
+			state->fingerprints[idx] = 0;
+			continue;
+		}
+		mi_vector_hash(state->key_buf + state->key_off[i],
+		    state->key_off[i + 1] - state->key_off[i],
+		    state->seed, hashes);
+		state->fingerprints[idx] = fingerprint(hashes);
+	}
+	free(nkeys);
+	return 0;
+}
+
 static size_t
 compute_size(uint32_t size)
 {
@@ -504,6 +718,16 @@ print_hash(struct cdbw *cdbw, struct state *state, int fd, const char *descr)
 				return -1;
 		}
 	}
+	if (state->fingerprints != NULL) {
+		COND_FLUSH_BUFFER(8);
+		memcpy(buf + cur_pos, "NBCDBFP\001", 8);
+		cur_pos += 8;
+		for (i = 0; i < cdbw->data_counter; ++i) {
+			COND_FLUSH_BUFFER(4);
+			le32enc(buf + cur_pos, state->fingerprints[i]);
+			cur_pos += 4;
+		}
+	}
 	if (cur_pos != 0) {
 		ret = write(fd, buf, cur_pos);
 		if (ret == -1 || (size_t)ret != cur_pos)
@@ -519,6 +743,7 @@ cdbw_output(struct cdbw *cdbw, int fd, const char descr[16],
 	struct state state;
 	int rv;
 
+	state.fingerprints = NULL;
 	if (cdbw->data_counter == 0 || cdbw->key_counter == 0) {
 		state.entries = 0;
 		state.seed = 0;
@@ -543,20 +768,30 @@ cdbw_output(struct cdbw *cdbw, int fd, const char descr[16],
 	NALLOC(state.vertices, state.entries);
 	NALLOC(state.edges, state.keys);
 	NALLOC(state.output_order, state.keys);
+	NALLOC(state.key_off, state.keys + 1);
 #undef NALLOC
+	state.key_buf = NULL;
 
 	if (state.g == NULL || state.visited == NULL || state.edges == NULL ||
-	    state.vertices == NULL || state.output_order == NULL) {
+	    state.vertices == NULL || state.output_order == NULL ||
+	    state.key_off == NULL || gather_keys(cdbw, &state)) {
 		rv = -1;
 		goto release;
 	}
 
 	state.seed = 0;
 	do {
-		++state.seed;
-	} while (build_graph(cdbw, &state));
+		if (seedgen == cdbw_stable_seeder)
+			++state.seed;
+		else
+			state.seed = (*seedgen)();
+	} while (build_graph(&state));
 
 	assign_nodes(&state);
+	if (cdbw->fingerprints && compute_fingerprints(&state)) {
+		rv = -1;
+		goto release;
+	}
 	rv = print_hash(cdbw, &state, fd, descr);
 
 release:
@@ -565,6 +800,9 @@ release:
 	free(state.vertices);
 	free(state.edges);
 	free(state.output_order);
+	free(state.key_off);
+	free(state.key_buf);
+	free(state.fingerprints);
 
 	return rv;
 }
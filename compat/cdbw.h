@@ -47,6 +47,7 @@ int		 cdbw_put_data(struct cdbw *, const void *, size_t,
 int		 cdbw_put_key(struct cdbw *, const void *, size_t,
     uint32_t);
 uint32_t	 cdbw_stable_seeder(void);
+void		 cdbw_set_fingerprints(struct cdbw *, int);
 int		 cdbw_output(struct cdbw *, int, const char[16],
     uint32_t (*)(void));
 void		 cdbw_close(struct cdbw *);
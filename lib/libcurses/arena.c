@@ -0,0 +1,246 @@
+/*	$NetBSD$	*/
+
+/*
+ * Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "curses.h"
+#include "curses_private.h"
+
+/*
+ * Per screen storage for windows.
+ *
+ * Window headers are carved out of slabs and recycled through a free
+ * list, line bookkeeping and cell storage come from power of two size
+ * classes that are cached on the screen when released.  Applications
+ * that create and destroy many short lived windows therefore keep
+ * reusing the same few blocks instead of fragmenting the heap, and
+ * delscreen() can hand everything back in one go.
+ */
+
+struct __winslab {
+	struct __winslab	*next;
+	WINDOW			 wins[ARENA_SLABWINS];
+};
+
+struct __arenablk {
+	struct __arenablk	*next;	/* Next free block in class. */
+	size_t			 size;	/* Usable size of the block. */
+};
+
+#define	ARENA_HDRSIZE	sizeof(struct __arenablk)
+
+/*
+ * __arena_class --
+ *	Return the size class for a request of len bytes, or ARENA_NCLASS
+ *	if the request is too large to be cached.
+ */
+static int
+__arena_class(size_t len)
+{
+	int	c;
+
+	for (c = 0; c < ARENA_NCLASS; c++)
+		if (len <= ((size_t)1 << (c + ARENA_MINSHIFT)))
+			return c;
+	return ARENA_NCLASS;
+}
+
+/*
+ * __arena_winalloc --
+ *	Return a zeroed window header from the screen's slabs.
+ */
+WINDOW *
+__arena_winalloc(SCREEN *screen)
+{
+	struct __arena		*arena = &screen->arena;
+	struct __winslab	*slab;
+	WINDOW			*win;
+	int			 i;
+
+	if (arena->freewins == NULL) {
+		if ((slab = malloc(sizeof(*slab))) == NULL)
+			return NULL;
+		slab->next = arena->slabs;
+		arena->slabs = slab;
+		for (i = ARENA_SLABWINS - 1; i >= 0; i--) {
+			slab->wins[i].nextp = arena->freewins;
+			arena->freewins = &slab->wins[i];
+		}
+	}
+
+	win = arena->freewins;
+	arena->freewins = win->nextp;
+	memset(win, 0, sizeof(*win));
+	return win;
+}
+
+/*
+ * __arena_winfree --
+ *	Return a window header to the slab free list of its screen.
+ */
+void
+__arena_winfree(WINDOW *win)
+{
+	struct __arena	*arena = &win->screen->arena;
+
+	win->nextp = arena->freewins;
+	arena->freewins = win;
+}
+
+/*
+ * __arena_alloc --
+ *	Allocate len bytes of window storage, reusing a cached block of
+ *	the right size class if there is one.
+ */
+void *
+__arena_alloc(SCREEN *screen, size_t len)
+{
+	struct __arena		*arena = &screen->arena;
+	struct __arenablk	*blk;
+	int			 c;
+
+	c = __arena_class(len);
+	if (c < ARENA_NCLASS) {
+		if ((blk = arena->freeblks[c]) != NULL) {
+			arena->freeblks[c] = blk->next;
+			arena->nfree[c]--;
+			return blk + 1;
+		}
+		len = (size_t)1 << (c + ARENA_MINSHIFT);
+	}
+
+	if ((blk = malloc(ARENA_HDRSIZE + len)) == NULL)
+		return NULL;
+	blk->size = len;
+	return blk + 1;
+}
+
+/*
+ * __arena_size --
+ *	Return the usable size of a block from __arena_alloc.
+ */
+size_t
+__arena_size(const void *p)
+{
+
+	return ((const struct __arenablk *)p - 1)->size;
+}
+
+/*
+ * __arena_free --
+ *	Release a block from __arena_alloc, keeping it cached on the
+ *	screen unless its class is already full.
+ */
+void
+__arena_free(SCREEN *screen, void *p)
+{
+	struct __arena		*arena = &screen->arena;
+	struct __arenablk	*blk;
+	int			 c;
+
+	if (p == NULL)
+		return;
+
+	blk = (struct __arenablk *)p - 1;
+	c = __arena_class(blk->size);
+	if (c == ARENA_NCLASS || arena->nfree[c] >= ARENA_MAXFREE) {
+		free(blk);
+		return;
+	}
+	blk->next = arena->freeblks[c];
+	arena->freeblks[c] = blk;
+	arena->nfree[c]++;
+}
+
+/*
+ * __arena_release --
+ *	Free all slabs and cached blocks of the screen.  Every window
+ *	of the screen must have been deleted already.
+ */
+void
+__arena_release(SCREEN *screen)
+{
+	struct __arena		*arena = &screen->arena;
+	struct __winslab	*slab;
+	struct __arenablk	*blk;
+	int			 c;
+
+	while ((slab = arena->slabs) != NULL) {
+		arena->slabs = slab->next;
+		free(slab);
+	}
+	arena->freewins = NULL;
+
+	for (c = 0; c < ARENA_NCLASS; c++) {
+		while ((blk = arena->freeblks[c]) != NULL) {
+			arena->freeblks[c] = blk->next;
+			free(blk);
+		}
+		arena->nfree[c] = 0;
+	}
+}
+
+/*
+ * __winlist_insert --
+ *	Append a top level window to the window list of its screen.
+ */
+void
+__winlist_insert(SCREEN *screen, WINDOW *win)
+{
+	struct __winlist	*wlp = &win->winlist;
+
+	wlp->winp = win;
+	wlp->nextp = NULL;
+	wlp->prevp = screen->winlistt;
+	if (screen->winlistt != NULL)
+		screen->winlistt->nextp = wlp;
+	else
+		screen->winlistp = wlp;
+	screen->winlistt = wlp;
+}
+
+/*
+ * __winlist_remove --
+ *	Unlink a top level window from the window list of its screen.
+ */
+void
+__winlist_remove(SCREEN *screen, WINDOW *win)
+{
+	struct __winlist	*wlp = &win->winlist;
+
+	if (wlp->prevp != NULL)
+		wlp->prevp->nextp = wlp->nextp;
+	else
+		screen->winlistp = wlp->nextp;
+	if (wlp->nextp != NULL)
+		wlp->nextp->prevp = wlp->prevp;
+	else
+		screen->winlistt = wlp->prevp;
+	wlp->nextp = wlp->prevp = NULL;
+}
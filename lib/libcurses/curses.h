@@ -204,6 +204,7 @@ typedef chtype cchar_t;
 #define    KEY_UNDO       0x198    /* Undo key */
 #define    KEY_MOUSE      0x199    /* Mouse event has occurred */
 #define    KEY_RESIZE     0x200    /* Resize event has occurred */
+#define    KEY_PASTE      0x201    /* Text has been pasted */
 #define    KEY_MAX        0x240    /* maximum extended key value */
 #define    KEY_CODE_YES   0x241    /* A function key was pressed */
 
@@ -683,6 +684,10 @@ int	 immedok(WINDOW *, bool);
 int	 init_color(short, short, short, short);
 int	 init_pair(short, short, short);
 WINDOW	*initscr(void);
+int	 input_deadline(WINDOW *);
+int	 input_fd(void);
+int	 input_feed(const char *, size_t);
+int	 input_getch(WINDOW *);
 int	 intrflush(WINDOW *, bool);
 bool	 isendwin(void);
 bool	 is_linetouched(WINDOW *, int);
@@ -725,6 +730,8 @@ int	 notimeout(WINDOW *, bool);
 int	 overlay(const WINDOW *, WINDOW *);
 int	 overwrite(const WINDOW *, WINDOW *);
 int	 pair_content(short, short *, short *);
+const char *paste_buffer(size_t *);
+int	 paste_mode(bool);
 int	 pechochar(WINDOW *, const chtype);
 int	 pnoutrefresh(WINDOW *, int, int, int, int, int, int);
 int	 prefresh(WINDOW *, int, int, int, int, int, int);
@@ -737,6 +744,8 @@ int	 reset_prog_mode(void);
 int	 reset_shell_mode(void);
 int	 resetty(void);
 int      resizeterm(int, int);
+int	 resize_fd(void);
+int	 resize_poll(void);
 int	 resize_term(int, int);
 int	 ripoffline(int, int (*)(WINDOW *, int));
 int	 savetty(void);
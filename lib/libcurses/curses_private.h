@@ -42,6 +42,7 @@
 #include <limits.h>
 #include <term.h>
 #include <termios.h>
+#include <time.h>
 
 /* Private structure definitions for curses. */
 
@@ -108,16 +109,25 @@ struct __line {
 	__LDATA *line;			/* Pointer to the line text. */
 };
 
+struct __winlist {
+	struct __window		*winp;	/* The window. */
+	struct __winlist	*nextp;	/* Next window. */
+	struct __winlist	*prevp;	/* Previous window. */
+};
+
 struct __window {		/* Window structure. */
 	struct __window	*nextp, *orig;	/* Subwindows list and parent. */
+	struct __winlist winlist;	/* Entry in the screen window list. */
 	int begy, begx;			/* Window home. */
 	int cury, curx;			/* Current x, y coordinates. */
 	int maxy, maxx;			/* Maximum values for curx, cury. */
 	int reqy, reqx;			/* Size requested when created */
 	int ch_off;			/* x offset for firstch/lastch. */
 	__LINE **alines;		/* Array of pointers to the lines */
-	__LINE  *lspace;		/* line space (for cleanup) */
-	__LDATA *wspace;		/* window space (for cleanup) */
+	__LINE  *lspace;		/* line space (arena block) */
+	__LDATA *wspace;		/* window space (within lspace block) */
+	int	 ycap;			/* Lines allocated in line space */
+	int	 stride;		/* Cells per line in window space */
 
 #define	__ENDLINE	0x00000001	/* End of screen. */
 #define	__FLUSH		0x00000002	/* Fflush(stdout) after refresh. */
@@ -166,11 +176,6 @@ struct __window {		/* Window structure. */
 	| WA_TOP | WA_LOW | WA_LEFT | WA_RIGHT | WA_HORIZONTAL | WA_VERTICAL)
 #endif /* HAVE_WCHAR */
 
-struct __winlist {
-	struct __window		*winp;	/* The window. */
-	struct __winlist	*nextp;	/* Next window. */
-};
-
 struct __color {
 	short	num;
 	short	red;
@@ -210,6 +215,18 @@ struct __slk_label {
 	int	 x;
 };
 
+/* Window storage arena, see arena.c */
+#define	ARENA_SLABWINS	16	/* Window headers per slab. */
+#define	ARENA_MINSHIFT	6	/* Smallest block class is 64 bytes. */
+#define	ARENA_NCLASS	16	/* Largest cached block class is 2MB. */
+#define	ARENA_MAXFREE	8	/* Cached free blocks per class. */
+struct __arena {
+	struct __winslab	*slabs;		/* Window header slabs. */
+	struct __window		*freewins;	/* Free window headers. */
+	struct __arenablk	*freeblks[ARENA_NCLASS]; /* Cached blocks. */
+	int			 nfree[ARENA_NCLASS];
+};
+
 #define	MAX_RIPS	5
 struct __ripoff {
 	int	nlines;
@@ -271,7 +288,8 @@ struct __screen {
 	int noqch;
 	int clearok;
 	int useraw;
-	struct __winlist *winlistp;
+	struct __winlist *winlistp, *winlistt;	/* Window list head, tail */
+	struct __arena	 arena;		/* Window storage. */
 	struct   termios cbreakt, rawt, *curt, save_termios;
 	struct termios orig_termios, baset, savedtty;
 	int ovmin;
@@ -282,9 +300,24 @@ struct __screen {
 	char padchar;
 	int endwin;
 	int ttyfd;
-	int resized;
+	int resized;		/* Window size change pending. */
+#define	RESIZE_SETTLE		10  /* ms without a size change to settle */
+#define	RESIZE_SETTLE_MAX	10  /* Wait at most this many times. */
 	wchar_t *unget_list;
 	int unget_len, unget_pos;
+	unsigned char *feedbuf;	/* Input handed over by input_feed(). */
+	size_t feedpos, feedlen, feedsize;
+	struct timespec feedtime; /* When input was last fed. */
+	int paste;		/* Bracketed paste enabled. */
+#define	PASTE_ON	"\033[?2004h"
+#define	PASTE_OFF	"\033[?2004l"
+#define	PASTE_START	"\033[200~"
+#define	PASTE_END	"\033[201~"
+#define	PASTE_TIMEOUT	5   /* Give up on a quiet paste (tenths of secs). */
+	int pasting;		/* Collecting a paste. */
+	int pastematch;		/* Bytes of PASTE_END seen. */
+	char *pastebuf;
+	size_t pastelen, pastesize;
 	int filtered;
 	int checkfd;
 
@@ -352,6 +385,13 @@ void	 __CTRACE(int, const char *, ...) __attribute__((__format__(__printf__, 2,
 #endif
 
 /* Private functions. */
+int	 __alloc_lines(WINDOW *, int, int, int);
+void	*__arena_alloc(SCREEN *, size_t);
+void	 __arena_free(SCREEN *, void *);
+void	 __arena_release(SCREEN *);
+size_t	 __arena_size(const void *);
+WINDOW	*__arena_winalloc(SCREEN *);
+void	 __arena_winfree(WINDOW *);
 int     __cputchar_args(int, void *);
 void     _cursesi_free_keymap(keymap_t *);
 int      _cursesi_gettmode(SCREEN *);
@@ -382,12 +422,16 @@ void	__cursesi_win_free_nsp(WINDOW *);
 void	__cursesi_putnsp(nschar_t *, const int, const int);
 void	__cursesi_chtype_to_cchar(chtype, cchar_t *);
 #endif /* HAVE_WCHAR */
-int	 __fgetc_resize(FILE *);
+int	 __fgetc_resize(FILE *, int);
 int	 __unget(wint_t);
 int	 __mvcur(int, int, int, int, int);
 WINDOW  *__newwin(SCREEN *, int, int, int, int, int, int);
 int	 __nodelay(void);
 int	 __notimeout(void);
+void	 __paste_begin(SCREEN *);
+void	 __paste_end(SCREEN *);
+void	 __paste_read(SCREEN *);
+size_t	 __paste_scan(SCREEN *, const unsigned char *, size_t, int *);
 void	 __restartwin(void);
 void	 __restore_colors(void);
 void     __restore_cursor_vis(void);
@@ -396,6 +440,7 @@ void	 __restore_termios(void);
 void	 __restore_stophandler(void);
 void	 __restore_winchhandler(void);
 int	 __ripoffscreen(SCREEN *);
+void	 __resize_settle(int);
 int	 __ripoffresize(SCREEN *);
 void	 __ripofftouch(SCREEN *);
 int	 __rippedlines(const SCREEN *, int);
@@ -422,6 +467,8 @@ void	 __unset_color(WINDOW *win);
 int	 __waddch(WINDOW *, __LDATA *);
 int	 __wgetnstr(WINDOW *, char *, int);
 void	 __winch_signal_handler(int);
+void	 __winlist_insert(SCREEN *, WINDOW *);
+void	 __winlist_remove(SCREEN *, WINDOW *);
 
 /* Private #defines. */
 #define	min(a,b)	((a) < (b) ? (a) : (b))
@@ -42,13 +42,13 @@ int
 delwin(WINDOW *win)
 {
 	WINDOW *wp, *np;
-	struct __winlist *wl, *pwl;
 	SCREEN *screen;
 
 	__CTRACE(__CTRACE_WINDOW, "delwin(%p)\n", (void *)win);
 
 	if (win == NULL)
 		return OK;
+	screen = win->screen;
 
 	/*
 	 * Free any storage used by non-spacing characters in the window.
@@ -60,9 +60,9 @@ delwin(WINDOW *win)
 	if (win->orig == NULL) {
 		/*
 		 * If we are the original window, delete the space for all
-		 * the subwindows and the window space.
+		 * the subwindows.  The window space is released with the
+		 * line space below.
 		 */
-		free(win->wspace);
 		wp = win->nextp;
 		while (wp != win) {
 			np = wp->nextp;
@@ -70,18 +70,7 @@ delwin(WINDOW *win)
 			wp = np;
 		}
 		/* Remove ourselves from the list of windows on the screen. */
-		pwl = NULL;
-		screen = win->screen;
-		for (wl = screen->winlistp; wl; pwl = wl, wl = wl->nextp) {
-			if (wl->winp != win)
-				continue;
-			if (pwl != NULL)
-				pwl->nextp = wl->nextp;
-			else
-				screen->winlistp = wl->nextp;
-			free(wl);
-			break;
-		}
+		__winlist_remove(screen, win);
 	} else {
 		/*
 		 * If we are a subwindow, take ourselves out of the list.
@@ -93,8 +82,7 @@ delwin(WINDOW *win)
 			continue;
 		wp->nextp = win->nextp;
 	}
-	free(win->lspace);
-	free(win->alines);
+	__arena_free(screen, win->lspace);
 	if (win == _cursesi_screen->curscr)
 		_cursesi_screen->curscr = NULL;
 	if (win == _cursesi_screen->stdscr)
@@ -104,6 +92,6 @@ delwin(WINDOW *win)
 	if (win->fp)
 		fclose(win->fp);
 	free(win->buf);
-	free(win);
+	__arena_winfree(win);
 	return OK;
 }
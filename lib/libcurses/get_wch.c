@@ -48,7 +48,7 @@ extern short _cursesi_state;	/* storage declared in getch.c */
 
 /* prototypes for private functions */
 static int inkey(wchar_t *wc, int to, int delay);
-static wint_t __fgetwc_resize(FILE *infd, bool *resized);
+static wint_t __fgetwc_resize(FILE *infd, int delay, bool *resized);
 
 /*
  * __init_get_wch - initialise all the pointers & structures needed to make
@@ -67,6 +67,7 @@ __init_get_wch(SCREEN *screen)
 /*
  * inkey - do the work to process keyboard input, check for multi-key
  * sequences and return the appropriate symbol if we get a match.
+ * delay is the delay of the window being read, see wtimeout().
  *
  */
 static int
@@ -85,15 +86,15 @@ inkey(wchar_t *wc, int to, int delay)
 	__CTRACE(__CTRACE_INPUT, "inkey (%p, %d, %d)\n", (void *)wc, to, delay);
 	for (;;) { /* loop until we get a complete key sequence */
 		if (wstate == INKEY_NORM) {
-			if (delay && __timeout(delay) == ERR)
+			if (delay > 0 && __timeout(delay) == ERR)
 				return ERR;
-			c = __fgetc_resize(infd);
+			c = __fgetc_resize(infd, delay);
 			if (c == ERR || c == KEY_RESIZE) {
 				clearerr(infd);
 				return c;
 			}
 
-			if (delay && (__notimeout() == ERR))
+			if (delay > 0 && (__notimeout() == ERR))
 				return ERR;
 
 			k = (wchar_t)c;
@@ -120,7 +121,7 @@ inkey(wchar_t *wc, int to, int delay)
 			}
 		} else if (wstate == INKEY_ASSEMBLING) {
 			/* assembling a key sequence */
-			if (delay) {
+			if (delay > 0) {
 				if (__timeout(to ? (ESCDELAY / 100) : delay)
 						== ERR)
 					return ERR;
@@ -129,13 +130,13 @@ inkey(wchar_t *wc, int to, int delay)
 					return ERR;
 			}
 
-			c = __fgetc_resize(infd);
+			c = __fgetc_resize(infd, delay);
 			if (ferror(infd)) {
 				clearerr(infd);
 				return c;
 			}
 
-			if ((to || delay) && (__notimeout() == ERR))
+			if ((to || delay > 0) && (__notimeout() == ERR))
 				return ERR;
 
 			k = (wchar_t)c;
@@ -164,7 +165,7 @@ inkey(wchar_t *wc, int to, int delay)
 			}
 		} else if (wstate == INKEY_WCASSEMBLING) {
 			/* assembling a wide-char sequence */
-			if (delay) {
+			if (delay > 0) {
 				if (__timeout(to ? (ESCDELAY / 100) : delay)
 						== ERR)
 					return ERR;
@@ -173,13 +174,13 @@ inkey(wchar_t *wc, int to, int delay)
 					return ERR;
 			}
 
-			c = __fgetc_resize(infd);
+			c = __fgetc_resize(infd, delay);
 			if (ferror(infd)) {
 				clearerr(infd);
 				return c;
 			}
 
-			if ((to || delay) && (__notimeout() == ERR))
+			if ((to || delay > 0) && (__notimeout() == ERR))
 				return ERR;
 
 			k = (wchar_t)c;
@@ -449,8 +450,7 @@ wget_wch(WINDOW *win, wint_t *ch)
 	    "__rawmode = %d, __nl = %d, flags = %#.4x\n",
 	    __echoit, __rawmode, _cursesi_screen->nl, win->flags);
 	if (_cursesi_screen->resized) {
-		resizeterm(LINES, COLS);
-		_cursesi_screen->resized = 0;
+		__resize_settle(win->delay);
 		*ch = KEY_RESIZE;
 		return KEY_CODE_YES;
 	}
@@ -478,7 +478,7 @@ wget_wch(WINDOW *win, wint_t *ch)
 		switch (win->delay) {
 			case -1:
 				ret = inkey(&inp,
-					win->flags & __NOTIMEOUT ? 0 : 1, 0);
+					win->flags & __NOTIMEOUT ? 0 : 1, -1);
 				break;
 			case 0:
 				if (__nodelay() == ERR)
@@ -509,7 +509,7 @@ wget_wch(WINDOW *win, wint_t *ch)
 				break;
 		}
 
-		c = __fgetwc_resize(infd, &resized);
+		c = __fgetwc_resize(infd, win->delay, &resized);
 		if (c == WEOF) {
 			clearerr(infd);
 			__restore_termios();
@@ -534,6 +534,8 @@ wget_wch(WINDOW *win, wint_t *ch)
 	else
 		__CTRACE(__CTRACE_INPUT, "wget_wch got '%s'\n", unctrl(inp));
 #endif
+	if (ret == KEY_CODE_YES && inp == KEY_PASTE)
+		__paste_read(_cursesi_screen);
 	if (win->delay > -1) {
 		if (__delay() == ERR)
 			return ERR;
@@ -586,7 +588,7 @@ unget_wch(const wchar_t c)
  *    Any call to fgetwc(3) should use this function instead.
  */
 static wint_t
-__fgetwc_resize(FILE *infd, bool *resized)
+__fgetwc_resize(FILE *infd, int delay, bool *resized)
 {
 	wint_t c;
 
@@ -597,8 +599,7 @@ __fgetwc_resize(FILE *infd, bool *resized)
 	if (!ferror(infd) || errno != EINTR || !_cursesi_screen->resized)
 		return ERR;
 	__CTRACE(__CTRACE_INPUT, "__fgetwc_resize returning KEY_RESIZE\n");
-	resizeterm(LINES, COLS);
-	_cursesi_screen->resized = 0;
+	__resize_settle(delay);
 	*resized = true;
 	return c;
 }
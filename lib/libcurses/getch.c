@@ -519,6 +519,7 @@ new_key(void)
 /*
  * inkey - do the work to process keyboard input, check for multi-key
  * sequences and return the appropriate symbol if we get a match.
+ * delay is the delay of the window being read, see wtimeout().
  *
  */
 
@@ -536,15 +537,15 @@ inkey(int to, int delay)
 	for (;;) {		/* loop until we get a complete key sequence */
 reread:
 		if (_cursesi_state == INKEY_NORM) {
-			if (delay && __timeout(delay) == ERR)
+			if (delay > 0 && __timeout(delay) == ERR)
 				return ERR;
-			c = __fgetc_resize(infd);
+			c = __fgetc_resize(infd, delay);
 			if (c == ERR || c == KEY_RESIZE) {
 				clearerr(infd);
 				return c;
 			}
 
-			if (delay && (__notimeout() == ERR))
+			if (delay > 0 && (__notimeout() == ERR))
 				return ERR;
 
 			k = (wchar_t)c;
@@ -571,7 +572,7 @@ reread:
 			}
 		} else if (_cursesi_state == INKEY_ASSEMBLING) {
 			/* assembling a key sequence */
-			if (delay) {
+			if (delay > 0) {
 				if (__timeout(to ? (ESCDELAY / 100) : delay)
 				    == ERR)
 					return ERR;
@@ -580,13 +581,13 @@ reread:
 					return ERR;
 			}
 
-			c = __fgetc_resize(infd);
+			c = __fgetc_resize(infd, delay);
 			if (ferror(infd)) {
 				clearerr(infd);
 				return c;
 			}
 
-			if ((to || delay) && (__notimeout() == ERR))
+			if ((to || delay > 0) && (__notimeout() == ERR))
 					return ERR;
 
 			__CTRACE(__CTRACE_INPUT,
@@ -819,8 +820,7 @@ wgetch(WINDOW *win)
 	    "__rawmode = %d, __nl = %d, flags = %#.4x, delay = %d\n",
 	    __echoit, __rawmode, _cursesi_screen->nl, win->flags, win->delay);
 	if (_cursesi_screen->resized) {
-		resizeterm(LINES, COLS);
-		_cursesi_screen->resized = 0;
+		__resize_settle(win->delay);
 		__CTRACE(__CTRACE_INPUT, "wgetch returning KEY_RESIZE\n");
 		return KEY_RESIZE;
 	}
@@ -844,7 +844,7 @@ wgetch(WINDOW *win)
 	if (win->flags & __KEYPAD) {
 		switch (win->delay) {
 		case -1:
-			inp = inkey (win->flags & __NOTIMEOUT ? 0 : 1, 0);
+			inp = inkey (win->flags & __NOTIMEOUT ? 0 : 1, -1);
 			break;
 		case 0:
 			if (__nodelay() == ERR)
@@ -871,7 +871,7 @@ wgetch(WINDOW *win)
 			break;
 		}
 
-		inp = __fgetc_resize(infd);
+		inp = __fgetc_resize(infd, win->delay);
 		if (inp == ERR || inp == KEY_RESIZE) {
 			clearerr(infd);
 			__restore_termios();
@@ -888,6 +888,8 @@ wgetch(WINDOW *win)
 	else
 		__CTRACE(__CTRACE_INPUT, "wgetch got '%s'\n", unctrl(inp));
 #endif
+	if (inp == KEY_PASTE)
+		__paste_read(_cursesi_screen);
 	if (win->delay > -1) {
 		if (__delay() == ERR)
 			return ERR;
@@ -985,9 +987,10 @@ set_escdelay(int escdelay)
  * __fgetc_resize --
  *    Any call to fgetc(3) should use this function instead
  *    and test for the return value of KEY_RESIZE as well as ERR.
+ *    delay limits the wait for a resize to settle, see __resize_settle().
  */
 int
-__fgetc_resize(FILE *infd)
+__fgetc_resize(FILE *infd, int delay)
 {
 	int c;
 
@@ -998,7 +1001,6 @@ __fgetc_resize(FILE *infd)
 	if (!ferror(infd) || errno != EINTR || !_cursesi_screen->resized)
 		return ERR;
 	__CTRACE(__CTRACE_INPUT, "__fgetc_resize returning KEY_RESIZE\n");
-	resizeterm(LINES, COLS);
-	_cursesi_screen->resized = 0;
+	__resize_settle(delay);
 	return KEY_RESIZE;
 }
@@ -0,0 +1,264 @@
+/*	$NetBSD$	*/
+
+/*
+ * Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "curses.h"
+#include "curses_private.h"
+#include "keymap.h"
+
+/*
+ * Input for applications with their own event loop.
+ *
+ * The application reads the terminal itself, whenever poll(2) or
+ * whatever it uses says there is something to read, and hands the bytes
+ * to input_feed().  They are decoded against the same keymaps as wgetch()
+ * uses, but nothing here ever reads, sleeps or touches the terminal
+ * modes.  A partial escape sequence is held back until either the rest
+ * arrives or ESCDELAY has passed since the last byte was fed, and
+ * input_deadline() tells the loop when that will be.
+ */
+
+#define	FEED_NOMATCH	-1	/* Buffered input is not a key sequence. */
+#define	FEED_PARTIAL	-2	/* Buffered input starts a key sequence. */
+
+/*
+ * __feed_match --
+ *	Match the buffered input against the keymaps without consuming it.
+ *	Return the key symbol and store the length of its sequence in lenp,
+ *	or return FEED_NOMATCH or FEED_PARTIAL.
+ */
+static int
+__feed_match(SCREEN *screen, size_t *lenp)
+{
+	keymap_t	*current = screen->base_keymap;
+	key_entry_t	*key;
+	size_t		 i;
+	short		 mapping;
+
+	for (i = screen->feedpos; i < screen->feedlen; i++) {
+		mapping = current->mapping[screen->feedbuf[i]];
+		if (mapping < 0)
+			return FEED_NOMATCH;
+		key = current->key[mapping];
+		if (key->type == KEYMAP_LEAF) {
+			if (key->enable == FALSE)
+				return FEED_NOMATCH;
+			*lenp = i - screen->feedpos + 1;
+			return key->value.symbol;
+		}
+		current = key->value.next;
+	}
+	return FEED_PARTIAL;
+}
+
+/*
+ * __feed_elapsed --
+ *	Return the milliseconds since input was last fed.
+ */
+static long
+__feed_elapsed(SCREEN *screen)
+{
+	struct timespec	now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now) == -1)
+		return 0;
+	return (now.tv_sec - screen->feedtime.tv_sec) * 1000L +
+	    (now.tv_nsec - screen->feedtime.tv_nsec) / 1000000L;
+}
+
+/*
+ * __feed_paste --
+ *	Move fed input into the paste being collected.  Return KEY_PASTE
+ *	once it is complete, or if input stopped arriving in the middle of
+ *	it, otherwise ERR.
+ */
+static int
+__feed_paste(SCREEN *screen)
+{
+	int	done;
+
+	screen->feedpos += __paste_scan(screen,
+	    screen->feedbuf + screen->feedpos,
+	    screen->feedlen - screen->feedpos, &done);
+	if (!done && __feed_elapsed(screen) < PASTE_TIMEOUT * 100)
+		return ERR;
+	__paste_end(screen);
+	return KEY_PASTE;
+}
+
+/*
+ * input_fd --
+ *	Return the file descriptor the current screen takes input from.
+ */
+int
+input_fd(void)
+{
+
+	if (_cursesi_screen == NULL || _cursesi_screen->infd == NULL)
+		return ERR;
+	return fileno(_cursesi_screen->infd);
+}
+
+/*
+ * input_feed --
+ *	Append len bytes read from the terminal to the input buffer of
+ *	the current screen.
+ */
+int
+input_feed(const char *buf, size_t len)
+{
+	SCREEN		*screen = _cursesi_screen;
+	unsigned char	*p;
+	size_t		 size;
+
+	if (screen == NULL || (buf == NULL && len != 0))
+		return ERR;
+
+	__CTRACE(__CTRACE_INPUT, "input_feed: %zu bytes\n", len);
+	if (screen->feedpos == screen->feedlen)
+		screen->feedpos = screen->feedlen = 0;
+	if (len > screen->feedsize - screen->feedlen) {
+		if (screen->feedpos != 0) {
+			memmove(screen->feedbuf,
+			    screen->feedbuf + screen->feedpos,
+			    screen->feedlen - screen->feedpos);
+			screen->feedlen -= screen->feedpos;
+			screen->feedpos = 0;
+		}
+		if (len > screen->feedsize - screen->feedlen) {
+			size = screen->feedsize ? screen->feedsize * 2 : 64;
+			while (size < screen->feedlen + len)
+				size *= 2;
+			if ((p = realloc(screen->feedbuf, size)) == NULL)
+				return ERR;
+			screen->feedbuf = p;
+			screen->feedsize = size;
+		}
+	}
+
+	if (len != 0)
+		memcpy(screen->feedbuf + screen->feedlen, buf, len);
+	screen->feedlen += len;
+	(void)clock_gettime(CLOCK_MONOTONIC, &screen->feedtime);
+	return OK;
+}
+
+/*
+ * input_getch --
+ *	Return the next key decoded from the fed input, or ERR if no
+ *	complete key is available yet.  Never blocks.
+ */
+int
+input_getch(WINDOW *win)
+{
+	SCREEN	*screen = _cursesi_screen;
+	size_t	 len;
+	int	 c;
+
+	if (screen == NULL || win == NULL)
+		return ERR;
+
+	if ((c = resize_poll()) != ERR)
+		return c;
+
+	if (screen->unget_pos) {
+		screen->unget_pos--;
+		return screen->unget_list[screen->unget_pos];
+	}
+
+	if (screen->pasting)
+		return __feed_paste(screen);
+
+	if (screen->feedpos == screen->feedlen)
+		return ERR;
+
+	c = FEED_NOMATCH;
+	if (win->flags & __KEYPAD) {
+		c = __feed_match(screen, &len);
+		if (c == FEED_PARTIAL) {
+			/* Wait for the rest unless it is overdue. */
+			if (win->flags & __NOTIMEOUT ||
+			    __feed_elapsed(screen) < ESCDELAY)
+				return ERR;
+			c = FEED_NOMATCH;
+		}
+	}
+	if (c == FEED_NOMATCH) {
+		c = screen->feedbuf[screen->feedpos];
+		len = 1;
+	}
+	screen->feedpos += len;
+
+	if (c == KEY_PASTE) {
+		__paste_begin(screen);
+		return __feed_paste(screen);
+	}
+	if (screen->nl && c == 13)
+		c = 10;
+	__CTRACE(__CTRACE_INPUT, "input_getch: %d\n", c);
+	return c;
+}
+
+/*
+ * input_deadline --
+ *	Return the number of milliseconds after which input_getch() will
+ *	give up waiting for the rest of a key sequence, 0 if a key can be
+ *	read now or -1 if only more input will produce a key.
+ */
+int
+input_deadline(WINDOW *win)
+{
+	SCREEN	*screen = _cursesi_screen;
+	size_t	 len;
+	long	 left;
+
+	if (screen == NULL || win == NULL)
+		return -1;
+	if (screen->resized || screen->unget_pos)
+		return 0;
+	if (screen->pasting) {
+		if (screen->feedpos != screen->feedlen)
+			return 0;
+		left = PASTE_TIMEOUT * 100 - __feed_elapsed(screen);
+		return left > 0 ? (int)left : 0;
+	}
+	if (screen->feedpos == screen->feedlen)
+		return -1;
+	if (!(win->flags & __KEYPAD) ||
+	    __feed_match(screen, &len) != FEED_PARTIAL)
+		return 0;
+	if (win->flags & __NOTIMEOUT)
+		return -1;
+
+	left = ESCDELAY - __feed_elapsed(screen);
+	return left > 0 ? (int)left : 0;
+}
@@ -475,6 +475,10 @@ keyname(int key)
 		strncpy(name, "KEY_RESIZE\0", KEYNAMEMAX);
 		return name;
 	}
+	if (key == KEY_PASTE) {
+		strncpy(name, "KEY_PASTE\0", KEYNAMEMAX);
+		return name;
+	}
 	/* No more names. */
 	strncpy(name, "UNKNOWN KEY\0", KEYNAMEMAX);
 	return name;
@@ -235,6 +235,51 @@ __set_subwin(WINDOW *orig, WINDOW *win)
 	__CTRACE(__CTRACE_WINDOW, "__set_subwin: win->ch_off = %d\n",
 	    win->ch_off);
 }
+/*
+ * __alloc_lines --
+ *	Allocate the line space, the line pointer array and, unless the
+ *	window is a subwindow, the window space as a single arena block
+ *	with room for ycap lines of stride cells each.  The line pointers
+ *	are set up in order and, for a window with its own window space,
+ *	each line is pointed at its row of the window space.
+ *	Any previous storage of the window is not released.
+ */
+int
+__alloc_lines(WINDOW *win, int ycap, int stride, int sub)
+{
+	__LINE	*lp;
+	size_t	 len;
+	char	*p;
+	int	 i;
+
+	len = ycap * (sizeof(__LINE) + sizeof(__LINE *));
+	if (!sub)
+		len += stride * ycap * sizeof(__LDATA);
+	if ((p = __arena_alloc(win->screen, len)) == NULL)
+		return ERR;
+
+	win->lspace = (__LINE *)p;
+	p += ycap * sizeof(__LINE);
+	win->alines = (__LINE **)p;
+	p += ycap * sizeof(__LINE *);
+	win->wspace = sub ? NULL : (__LDATA *)p;
+	win->ycap = ycap;
+	win->stride = sub ? 0 : stride;
+
+	for (lp = win->lspace, i = 0; i < ycap; i++, lp++) {
+		win->alines[i] = lp;
+		if (sub)
+			continue;
+		lp->line = &win->wspace[i * stride];
+#ifdef DEBUG
+		lp->sentinel = SENTINEL_VALUE;
+#endif
+		lp->firstchp = &lp->firstch;
+		lp->lastchp = &lp->lastch;
+	}
+	return OK;
+}
+
 /*
  * __makenew --
  *	Set up a window buffer and returns a pointer to it.
@@ -245,7 +290,6 @@ __makenew(SCREEN *screen, int nlines, int ncols, int by, int bx, int sub,
 {
 	WINDOW			*win;
 	__LINE			*lp;
-	struct __winlist	*wlp, *wlp2;
 	int			 i;
 
 
@@ -254,69 +298,32 @@ __makenew(SCREEN *screen, int nlines, int ncols, int by, int bx, int sub,
 	if (nlines <= 0 || ncols <= 0)
 		return NULL;
 
-	if ((win = malloc(sizeof(WINDOW))) == NULL)
+	if ((win = __arena_winalloc(screen)) == NULL)
 		return NULL;
 	__CTRACE(__CTRACE_WINDOW, "makenew: win = %p\n", (void *)win);
+	win->screen = screen;
 	win->fp = NULL;
 	win->buf = NULL;
 	win->buflen = 0;
 
-	/* Set up line pointer array and line space. */
-	if ((win->alines = malloc(nlines * sizeof(__LINE *))) == NULL) {
-		free(win);
+	/*
+	 * Set up line pointer array, line space and, if it is not a
+	 * subwindow, window space.
+	 */
+	if (__alloc_lines(win, nlines, ncols, sub) == ERR) {
+		__arena_winfree(win);
 		return NULL;
 	}
-	if ((win->lspace = malloc(nlines * sizeof(__LINE))) == NULL) {
-		free(win->alines);
-		free(win);
-		return NULL;
-	}
-	/* Don't allocate window and line space if it's a subwindow */
-	if (sub)
-		win->wspace = NULL;
-	else {
-		/*
-		 * Allocate window space in one chunk.
-		 */
-		if ((win->wspace =
-			malloc(ncols * nlines * sizeof(__LDATA))) == NULL) {
-			free(win->lspace);
-			free(win->alines);
-			free(win);
-			return NULL;
-		}
+	if (!sub) {
 		/*
 		 * Append window to window list.
 		 */
-		if ((wlp = malloc(sizeof(struct __winlist))) == NULL) {
-			free(win->wspace);
-			free(win->lspace);
-			free(win->alines);
-			free(win);
-			return NULL;
-		}
-		wlp->winp = win;
-		wlp->nextp = NULL;
-		if (screen->winlistp == NULL)
-			screen->winlistp = wlp;
-		else {
-			wlp2 = screen->winlistp;
-			while (wlp2->nextp != NULL)
-				wlp2 = wlp2->nextp;
-			wlp2->nextp = wlp;
-		}
+		__winlist_insert(screen, win);
 		/*
-		 * Point line pointers to line space, and lines themselves into
-		 * window space.
+		 * Line pointers already point to line space, and lines
+		 * themselves into window space.
 		 */
 		for (lp = win->lspace, i = 0; i < nlines; i++, lp++) {
-			win->alines[i] = lp;
-			lp->line = &win->wspace[i * ncols];
-#ifdef DEBUG
-			lp->sentinel = SENTINEL_VALUE;
-#endif
-			lp->firstchp = &lp->firstch;
-			lp->lastchp = &lp->lastch;
 			if (ispad) {
 				lp->firstch = 0;
 				lp->lastch = ncols;
@@ -327,7 +334,6 @@ __makenew(SCREEN *screen, int nlines, int ncols, int by, int bx, int sub,
 		}
 	}
 	__CTRACE(__CTRACE_WINDOW, "makenew: ncols = %d\n", ncols);
-	win->screen = screen;
 	win->cury = win->curx = 0;
 	win->maxy = nlines;
 	win->maxx = ncols;
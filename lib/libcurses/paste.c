@@ -0,0 +1,222 @@
+/*	$NetBSD$	*/
+
+/*
+ * Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "curses.h"
+#include "curses_private.h"
+
+/*
+ * Bracketed paste.
+ *
+ * With the mode enabled the terminal wraps pasted text in PASTE_START
+ * and PASTE_END.  The start marker is decoded like any other function
+ * key, after which the payload is collected in one go without going
+ * through the keymaps, echo or newline translation, and handed to the
+ * application as a single KEY_PASTE.
+ */
+
+static char		paste_start[] = PASTE_START;
+static const char	paste_end[] = PASTE_END;
+#define	PASTE_ENDLEN	(sizeof(paste_end) - 1)
+
+/*
+ * __paste_begin --
+ *	Start collecting a new paste.
+ */
+void
+__paste_begin(SCREEN *screen)
+{
+
+	screen->pasting = 1;
+	screen->pastelen = 0;
+	screen->pastematch = 0;
+}
+
+/*
+ * __paste_append --
+ *	Append len bytes to the paste buffer, keeping room for a NUL.
+ */
+static int
+__paste_append(SCREEN *screen, const unsigned char *buf, size_t len)
+{
+	char	*p;
+	size_t	 size;
+
+	if (len >= screen->pastesize - screen->pastelen) {
+		size = screen->pastesize ? screen->pastesize * 2 : 256;
+		while (len >= size - screen->pastelen)
+			size *= 2;
+		if ((p = realloc(screen->pastebuf, size)) == NULL)
+			return ERR;
+		screen->pastebuf = p;
+		screen->pastesize = size;
+	}
+	memcpy(screen->pastebuf + screen->pastelen, buf, len);
+	screen->pastelen += len;
+	return OK;
+}
+
+/*
+ * __paste_end --
+ *	Finish the paste being collected, terminating the buffer.
+ */
+void
+__paste_end(SCREEN *screen)
+{
+	static const unsigned char nul;
+
+	screen->pasting = 0;
+	if (__paste_append(screen, &nul, 0) == OK)
+		screen->pastebuf[screen->pastelen] = '\0';
+}
+
+/*
+ * __paste_scan --
+ *	Add up to len bytes of pasted input to the paste being collected.
+ *	Runs without an escape character are copied in bulk.  Return the
+ *	number of bytes used, setting done once the end marker has been
+ *	seen.
+ */
+size_t
+__paste_scan(SCREEN *screen, const unsigned char *buf, size_t len,
+    int *done)
+{
+	const unsigned char	*esc;
+	size_t			 i, n;
+	unsigned char		 c;
+
+	*done = 0;
+	i = 0;
+	while (i < len) {
+		if (screen->pastematch == 0) {
+			esc = memchr(buf + i, paste_end[0], len - i);
+			n = esc == NULL ? len - i : (size_t)(esc - buf) - i;
+			if (__paste_append(screen, buf + i, n) == ERR)
+				goto fail;
+			i += n;
+			if (esc == NULL)
+				break;
+		}
+
+		c = buf[i++];
+		if (__paste_append(screen, &c, 1) == ERR)
+			goto fail;
+		if (c == (unsigned char)paste_end[screen->pastematch])
+			screen->pastematch++;
+		else
+			screen->pastematch = c == (unsigned char)paste_end[0];
+		if (screen->pastematch == PASTE_ENDLEN) {
+			screen->pastelen -= PASTE_ENDLEN;
+			*done = 1;
+			break;
+		}
+	}
+	return i;
+
+fail:
+	/* Out of memory, hand over what we have. */
+	*done = 1;
+	return i;
+}
+
+/*
+ * __paste_read --
+ *	Collect a paste from the terminal after its start marker has been
+ *	decoded.  Gives up if the terminal goes quiet before the end marker.
+ */
+void
+__paste_read(SCREEN *screen)
+{
+	unsigned char	c;
+	int		ch, done;
+
+	__paste_begin(screen);
+	if (__timeout(PASTE_TIMEOUT) == ERR) {
+		__paste_end(screen);
+		return;
+	}
+	done = 0;
+	while (!done && (ch = getc(screen->infd)) != EOF) {
+		c = (unsigned char)ch;
+		(void)__paste_scan(screen, &c, 1, &done);
+	}
+	clearerr(screen->infd);
+	__paste_end(screen);
+	(void)__notimeout();
+	__CTRACE(__CTRACE_INPUT, "__paste_read: %zu bytes\n",
+	    screen->pastelen);
+}
+
+/*
+ * paste_mode --
+ *	Turn bracketed paste on or off for the current screen.
+ */
+int
+paste_mode(bool bf)
+{
+	SCREEN	*screen = _cursesi_screen;
+
+	if (screen == NULL)
+		return ERR;
+
+	if (bf) {
+		if (keyok(KEY_PASTE, TRUE) == ERR &&
+		    define_key(paste_start, KEY_PASTE) == ERR)
+			return ERR;
+		if (!screen->paste)
+			tputs(PASTE_ON, 0, __cputchar);
+	} else {
+		(void)keyok(KEY_PASTE, FALSE);
+		if (screen->paste)
+			tputs(PASTE_OFF, 0, __cputchar);
+	}
+	screen->paste = bf ? 1 : 0;
+	return OK;
+}
+
+/*
+ * paste_buffer --
+ *	Return the text of the last paste and its length.
+ */
+const char *
+paste_buffer(size_t *lenp)
+{
+	SCREEN	*screen = _cursesi_screen;
+
+	if (screen == NULL || screen->pasting || screen->pastebuf == NULL) {
+		if (lenp != NULL)
+			*lenp = 0;
+		return NULL;
+	}
+	if (lenp != NULL)
+		*lenp = screen->pastelen;
+	return screen->pastebuf;
+}
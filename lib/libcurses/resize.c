@@ -29,6 +29,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "curses.h"
 #include "curses_private.h"
@@ -232,18 +233,108 @@ __resizeterm(WINDOW *win, int nlines, int ncols)
 	return __resizewin(win, newlines, newcols);
 }
 
+/*
+ * __dropcells --
+ *	Release the non-spacing storage of the cells of a line from column
+ *	sx up to, but not including, ex.  The cells may be exposed again
+ *	by a later resize, so clear the pointers as well.
+ */
+static void
+__dropcells(__LINE *lp, int sx, int ex)
+{
+#ifdef HAVE_WCHAR
+	__LDATA	*sp;
+
+	for (sp = &lp->line[sx]; sx < ex; sx++, sp++) {
+		__cursesi_free_nsp(sp->nsp);
+		sp->nsp = NULL;
+	}
+#endif
+}
+
+/*
+ * __blankcells --
+ *	Fill the cells of a line from column sx up to, but not including,
+ *	ex with the window background.  The cells are fresh, any contents
+ *	they had were dropped before.
+ */
+static int
+__blankcells(WINDOW *win, __LINE *lp, int sx, int ex)
+{
+	__LDATA	*sp;
+
+	for (sp = &lp->line[sx]; sx < ex; sx++, sp++) {
+		sp->attr = 0;
+#ifndef HAVE_WCHAR
+		sp->ch = win->bch;
+#else
+		sp->ch = (wchar_t)btowc((int)win->bch);
+		sp->nsp = NULL;
+		if (_cursesi_copy_nsp(win->bnsp, sp) == ERR)
+			return ERR;
+		SET_WCOL(*sp, 1);
+#endif /* HAVE_WCHAR */
+	}
+	return OK;
+}
+
+/*
+ * __growlines --
+ *	Move the lines of a window into a new block of at least nlines
+ *	lines of ncols cells, keeping the overlapping contents.  Cells
+ *	outside the overlap must have been dropped already.
+ */
+static int
+__growlines(WINDOW *win, int nlines, int ncols)
+{
+	__LINE	*olspace, **oalines, *lp, *olp;
+	int	 ycap, stride, keepy, keepx, i;
+
+	olspace = win->lspace;
+	oalines = win->alines;
+	ycap = win->ycap;
+	stride = win->stride;
+	/* Leave some headroom so that a drag resize does not move again. */
+	if (nlines > ycap)
+		ycap = nlines + nlines / 4;
+	if (win->orig == NULL && ncols > stride)
+		stride = ncols + ncols / 4;
+
+	if (__alloc_lines(win, ycap, stride, win->orig != NULL) == ERR)
+		return ERR;
+
+	keepy = min(win->maxy, nlines);
+	keepx = min(win->maxx, ncols);
+	for (i = 0; i < keepy; i++) {
+		lp = win->alines[i];
+		olp = oalines[i];
+		lp->flags = olp->flags;
+		lp->hash = olp->hash;
+		if (win->orig != NULL) {
+			lp->line = olp->line;
+			continue;
+		}
+		lp->firstch = olp->firstch;
+		lp->lastch = olp->lastch;
+		(void)memcpy(lp->line, olp->line, keepx * __LDATASIZE);
+	}
+	__arena_free(win->screen, olspace);
+	return OK;
+}
+
 /*
  * __resizewin --
- *	Resize the given window.
+ *	Resize the given window in place.  Contents that are still
+ *	inside the window are kept and only the newly exposed cells are
+ *	cleared and touched.  The storage is only moved if the window
+ *	grows beyond what was allocated for it.
  */
 static int
 __resizewin(WINDOW *win, int nlines, int ncols)
 {
-	__LINE			*lp, *olp, **newlines, *newlspace;
-	__LDATA			*sp;
-	__LDATA			*newwspace;
-	int			 i, j;
-	int			 y, x;
+	__LINE			*lp, *olp;
+	int			 i, moved;
+	int			 y, x, oy, ox;
 	WINDOW			*swin;
 
 	__CTRACE(__CTRACE_WINDOW, "resize: (%p, %d, %d)\n",
@@ -257,102 +348,88 @@ __resizewin(WINDOW *win, int nlines, int ncols)
 	__CTRACE(__CTRACE_WINDOW, "resize: win->scr_t = %d\n", win->scr_t);
 	__CTRACE(__CTRACE_WINDOW, "resize: win->scr_b = %d\n", win->scr_b);
 
-	/*
-	 * free up any non-spacing storage before we lose the
-	 * pointers...
-	 */
-#ifdef HAVE_WCHAR
-	__cursesi_win_free_nsp(win);
-#endif
-
 	if (nlines <= 0 || ncols <= 0)
 		nlines = ncols = 0;
-	else {
-		/* Reallocate line pointer array and line space. */
-		newlines = realloc(win->alines, nlines * sizeof(__LINE *));
-		if (newlines == NULL)
-			return ERR;
-		win->alines = newlines;
-
-		newlspace = realloc(win->lspace, nlines * sizeof(__LINE));
-		if (newlspace == NULL)
-			return ERR;
-		win->lspace = newlspace;
-	}
+	oy = win->maxy;
+	ox = win->maxx;
 
-	/* Don't allocate window and line space if it's a subwindow */
+	/*
+	 * Release the cells that fall outside the new size.  Subwindows
+	 * share the cells of their parent, which owns them.
+	 */
 	if (win->orig == NULL) {
-		/*
-		 * Allocate window space in one chunk.
-		 */
-		if (ncols != 0) {
-			newwspace = realloc(win->wspace,
-					    ncols * nlines * sizeof(__LDATA));
-			if (newwspace == NULL)
-				return ERR;
-			win->wspace = newwspace;
+		for (i = 0; i < oy; i++) {
+			if (i >= nlines)
+				__dropcells(win->alines[i], 0, ox);
+			else if (ncols < ox)
+				__dropcells(win->alines[i], ncols, ox);
 		}
+	}
 
-		/*
-		 * Point line pointers to line space, and lines themselves into
-		 * window space.
-		 */
-		for (lp = win->lspace, i = 0; i < nlines; i++, lp++) {
-			win->alines[i] = lp;
-			lp->line = &win->wspace[i * ncols];
-#ifdef DEBUG
-			lp->sentinel = SENTINEL_VALUE;
-#endif
-			lp->firstchp = &lp->firstch;
-			lp->lastchp = &lp->lastch;
-			lp->firstch = 0;
-			lp->lastch = ncols - 1;
-			lp->flags = __ISDIRTY;
-		}
-	} else {
+	if (nlines > win->ycap || (win->orig == NULL && ncols > win->stride))
+		if (__growlines(win, nlines, ncols) == ERR)
+			return ERR;
 
+	if (win->orig != NULL) {
 		win->ch_off = win->begx - win->orig->begx;
+		moved = 0;
 		  /* Point line pointers to line space. */
 		for (lp = win->lspace, i = 0; i < nlines; i++, lp++) {
 			win->alines[i] = lp;
 			olp = win->orig->alines[i + win->begy - win->orig->begy];
+			if (i < oy && lp->line != &olp->line[win->ch_off])
+				moved = 1;
 			lp->line = &olp->line[win->ch_off];
 #ifdef DEBUG
 			lp->sentinel = SENTINEL_VALUE;
 #endif
 			lp->firstchp = &olp->firstch;
 			lp->lastchp = &olp->lastch;
-			lp->flags = __ISDIRTY;
+			if (i >= oy)
+				lp->flags = 0;
 		}
+		/* The subwindow now shows other cells, expose all of it. */
+		if (moved)
+			oy = ox = 0;
 	}
 
-	win->cury = win->curx = 0;
 	win->maxy = nlines;
 	win->maxx = ncols;
+	if (win->cury >= win->maxy)
+		win->cury = win->maxy > 0 ? win->maxy - 1 : 0;
+	if (win->curx >= win->maxx)
+		win->curx = win->maxx > 0 ? win->maxx - 1 : 0;
 	win->scr_b = win->maxy - 1;
 	__swflags(win);
 
-	  /*
-	   * we must zot the window contents otherwise lines may pick
-	   * up attributes from the previous line when the window is
-	   * made smaller.  The client will redraw the window anyway
-	   * so this is no big deal.
-	   */
+	/*
+	 * Blank and touch the newly exposed cells.  Rows that were
+	 * already there keep their contents and their dirty state, but
+	 * must not claim changes past the new right edge.
+	 */
 	for (i = 0; i < win->maxy; i++) {
 		lp = win->alines[i];
-		for (sp = lp->line, j = 0; j < win->maxx; j++, sp++) {
-			sp->attr = 0;
-#ifndef HAVE_WCHAR
-			sp->ch = win->bch;
-#else
-			sp->ch = (wchar_t)btowc((int)win->bch);
-			sp->nsp = NULL;
-			if (_cursesi_copy_nsp(win->bnsp, sp) == ERR)
+		if (i < oy) {
+			lp->flags &= ~__ISPASTEOL;
+			if (win->orig == NULL && lp->lastch >= ncols)
+				lp->lastch = ncols - 1;
+			x = min(ox, ncols);
+		} else {
+			if (win->orig == NULL) {
+				lp->flags = 0;
+				lp->firstch = ncols;
+				lp->lastch = 0;
+			}
+			x = 0;
+		}
+		if (x < ncols) {
+			if (win->orig == NULL &&
+			    __blankcells(win, lp, x, ncols) == ERR)
 				return ERR;
-			SET_WCOL(*sp, 1);
-#endif /* HAVE_WCHAR */
+			__touchline(win, i, x, ncols - 1);
 		}
-		lp->hash = __hash_line(lp->line, ncols);
+		if (i >= oy || ncols != ox)
+			lp->hash = __hash_line(lp->line, ncols);
 	}
 
 	__CTRACE(__CTRACE_WINDOW, "resize: win->wattr = %08x\n", win->wattr);
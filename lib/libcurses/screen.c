@@ -174,7 +174,7 @@ newterm(char *type, FILE *outfd, FILE *infd)
 	    !t_cursor_address(new_screen->term))
 		goto error_exit;
 
-	new_screen->winlistp = NULL;
+	new_screen->winlistp = new_screen->winlistt = NULL;
 
 	if ((new_screen->curscr = __newwin(new_screen, 0,
 	    0, 0, 0, FALSE, FALSE)) == NULL)
@@ -250,6 +250,8 @@ delscreen(SCREEN *screen)
 
 	free(screen->stdbuf);
 	free(screen->unget_list);
+	free(screen->feedbuf);
+	free(screen->pastebuf);
 	if (_cursesi_screen == screen)
 		_cursesi_screen = NULL;
 	free(screen);
@@ -271,4 +273,7 @@ __delscreen(SCREEN *screen)
 			/* sanity - abort if window didn't remove itself */
 			break;
 	}
+
+	  /* release the window storage in bulk */
+	__arena_release(screen);
 }
@@ -33,6 +33,8 @@
 #include <sys/param.h>
 
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
 #include <termios.h>
 #include <unistd.h>
@@ -43,6 +45,14 @@
 static int tstp_set;
 static int winch_set;
 
+/*
+ * Window size changes are reported through a pipe so that they can be
+ * waited for alongside other descriptors.  At most one byte is kept in
+ * the pipe however many signals arrive before it is drained.
+ */
+static int winch_pipe[2] = { -1, -1 };
+static volatile sig_atomic_t winch_pending;
+
 static void (*otstpfn)(int) = SIG_DFL;
 
 static struct sigaction	owsa;
@@ -119,21 +129,37 @@ __restore_stophandler(void)
 	}
 }
 
+/*
+ * __winch_notify --
+ *	Flag a window size change and wake up anyone waiting on the
+ *	resize descriptor.  Safe to call from a signal handler.
+ */
+static void
+__winch_notify(void)
+{
+	int serrno;
+
+	_cursesi_screen->resized = 1;
+	if (winch_pending)
+		return;
+	winch_pending = 1;
+	if (winch_pipe[1] != -1) {
+		serrno = errno;
+		(void)write(winch_pipe[1], "", 1);
+		errno = serrno;
+	}
+}
+
 /*
  * winch_signal_handler --
  *	Handle winch signals by pushing KEY_RESIZE into the input stream.
+ *	The new size is only fetched once the burst of signals that a
+ *	resize generates has been collected, see __resize_settle().
  */
 void
 __winch_signal_handler(/*ARGSUSED*/int signo)
 {
-	struct winsize win;
 
-	if (ioctl(_cursesi_screen->ttyfd, TIOCGWINSZ, &win) != -1 &&
-	    win.ws_row != 0 && win.ws_col != 0)
-	{
-		LINES = win.ws_row;
-		COLS = win.ws_col;
-	}
 	/*
 	 * If there was a previous handler, call that,
 	 * otherwise tell getch() to send KEY_RESIZE.
@@ -142,9 +168,116 @@ __winch_signal_handler(/*ARGSUSED*/int signo)
 	    owsa.sa_handler != SIG_IGN &&
 	    owsa.sa_handler != SIG_ERR &&
 	    owsa.sa_handler != SIG_HOLD)
+	{
+		struct winsize win;
+
+		if (ioctl(_cursesi_screen->ttyfd, TIOCGWINSZ, &win) != -1 &&
+		    win.ws_row != 0 && win.ws_col != 0)
+		{
+			LINES = win.ws_row;
+			COLS = win.ws_col;
+		}
 		owsa.sa_handler(signo);
-	else
-		_cursesi_screen->resized = 1;
+	} else
+		__winch_notify();
+}
+
+/*
+ * __winch_drain --
+ *	Empty the resize pipe.
+ */
+static void
+__winch_drain(void)
+{
+	char buf[16];
+
+	if (winch_pipe[0] == -1)
+		return;
+	while (read(winch_pipe[0], buf, sizeof(buf)) > 0)
+		continue;
+}
+
+/*
+ * __resize_settle --
+ *	Handle a pending window size change.  Give a burst of size
+ *	changes a short while to finish first, but never wait longer than
+ *	delay allows: -1 waits the full settle time, 0 does not wait and
+ *	anything else is a limit in tenths of a second, as for win->delay.
+ *	The final size is taken from the terminal and the screen is
+ *	resized once.
+ */
+void
+__resize_settle(int delay)
+{
+	struct winsize win;
+	struct pollfd fds[1];
+	int nlines, ncols, i, left, wait;
+
+	left = delay < 0 ? RESIZE_SETTLE * RESIZE_SETTLE_MAX : delay * 100;
+	if (winch_pipe[0] != -1) {
+		fds[0].fd = winch_pipe[0];
+		fds[0].events = POLLIN;
+		for (i = 0; i < RESIZE_SETTLE_MAX && left > 0; i++) {
+			/*
+			 * Clear the flag before draining so that a change
+			 * arriving meanwhile writes to the pipe again.
+			 */
+			winch_pending = 0;
+			__winch_drain();
+			wait = left < RESIZE_SETTLE ? left : RESIZE_SETTLE;
+			left -= wait;
+			if (poll(fds, 1, wait) <= 0)
+				break;
+		}
+	}
+	winch_pending = 0;
+	__winch_drain();
+
+	nlines = LINES;
+	ncols = COLS;
+	if (ioctl(_cursesi_screen->ttyfd, TIOCGWINSZ, &win) != -1 &&
+	    win.ws_row != 0 && win.ws_col != 0)
+	{
+		nlines = win.ws_row;
+		ncols = win.ws_col;
+	}
+	__CTRACE(__CTRACE_INPUT, "__resize_settle: %d, %d\n", nlines, ncols);
+	resizeterm(nlines, ncols);
+
+	/*
+	 * Keep the flag if another change arrived in the meantime, its
+	 * byte may have been drained so make the descriptor readable again.
+	 */
+	_cursesi_screen->resized = winch_pending;
+	if (winch_pending && winch_pipe[1] != -1)
+		(void)write(winch_pipe[1], "", 1);
+}
+
+/*
+ * resize_fd --
+ *	Return a descriptor that becomes readable when the terminal has
+ *	been resized, for use with poll(2) and friends.
+ */
+int
+resize_fd(void)
+{
+
+	return winch_pipe[0] == -1 ? ERR : winch_pipe[0];
+}
+
+/*
+ * resize_poll --
+ *	If the terminal has been resized, resize the screen to the new
+ *	size and return KEY_RESIZE, otherwise return ERR.  Never blocks.
+ */
+int
+resize_poll(void)
+{
+
+	if (_cursesi_screen == NULL || !_cursesi_screen->resized)
+		return ERR;
+	__resize_settle(0);
+	return KEY_RESIZE;
 }
 
 /*
@@ -155,6 +288,15 @@ __set_winchhandler(void)
 {
 
 	__CTRACE(__CTRACE_MISC, "__set_winchhandler: %d\n", winch_set);
+	if (winch_pipe[0] == -1 && pipe(winch_pipe) == 0) {
+		int i;
+
+		for (i = 0; i < 2; i++) {
+			(void)fcntl(winch_pipe[i], F_SETFD, FD_CLOEXEC);
+			(void)fcntl(winch_pipe[i], F_SETFL,
+			    fcntl(winch_pipe[i], F_GETFL) | O_NONBLOCK);
+		}
+	}
 	if (!winch_set) {
 		struct sigaction sa;
 
@@ -227,6 +369,8 @@ __stopwin(void)
 
 	if ((curscr != NULL) && (curscr->flags & __KEYPAD))
 		(void)tputs(keypad_local, 0, __cputchar);
+	if (_cursesi_screen->paste)
+		(void)tputs(PASTE_OFF, 0, __cputchar);
 	(void)tputs(cursor_normal, 0, __cputchar);
 	(void)tputs(exit_ca_mode, 0, __cputchar);
 	(void)fflush(_cursesi_screen->outfd);
@@ -266,11 +410,11 @@ __restartwin(void)
 	{
 		if (win.ws_row != LINES) {
 			LINES = win.ws_row;
-			_cursesi_screen->resized = 1;
+			__winch_notify();
 		}
 		if (win.ws_col != COLS) {
 			COLS = win.ws_col;
-			_cursesi_screen->resized = 1;
+			__winch_notify();
 		}
 	}
 	/*
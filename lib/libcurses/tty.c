@@ -550,6 +550,9 @@ __startwin(SCREEN *screen)
 	if (screen->curscr->flags & __KEYPAD)
 		ti_puts(screen->term, t_keypad_xmit(screen->term), 0,
 		    __cputchar_args, (void *) screen->outfd);
+	if (screen->paste)
+		ti_puts(screen->term, PASTE_ON, 0,
+		    __cputchar_args, (void *) screen->outfd);
 	screen->endwin = 0;
 }
 
@@ -135,6 +135,7 @@ set_field_opts(FIELD *field, Form_Options options)
 	}
 	
 	fp->opts = options;
+	_formi_dirty_field(fp);
 
 	  /* if appropriate, redraw the field */
 	if ((field != NULL) && (field->parent != NULL)
@@ -170,6 +171,7 @@ field_opts_on(FIELD *field, Form_Options options)
 	}
 	
 	fp->opts |= options;
+	_formi_dirty_field(fp);
 	
 	  /* if appropriate, redraw the field */
 	if ((field != NULL) && (field->parent != NULL)
@@ -196,6 +198,7 @@ field_opts_off(FIELD *field, Form_Options options)
 		return E_CURRENT;
 	
 	fp->opts &= ~options;
+	_formi_dirty_field(fp);
 	
 	  /* if appropriate, redraw the field */
 	if ((field != NULL) && (field->parent != NULL)
@@ -246,6 +249,7 @@ set_field_just(FIELD *field, int justification)
 		return E_BAD_ARGUMENT;
 	
 	fp->justification = justification;
+	_formi_dirty_field(fp);
 
 	_formi_init_field_xpos(fp);
 	
@@ -317,6 +321,7 @@ field_buffer_init(FIELD *field, int buffer)
 	char *newp;
 	
 	if (buffer == 0) {
+		field->gen++;
 		field->start_char = 0;
 		field->start_line = 0;
 		field->row_xpos = 0;
@@ -337,6 +342,7 @@ field_buffer_init(FIELD *field, int buffer)
 
 		field->start_line = field->alines;
 		field->cur_line = field->alines;
+		_formi_dirty_field(field);
 		
 		  /* we have to hope the wrap works - if it does not then the
 		     buffer is pretty much borked */
@@ -574,6 +580,7 @@ set_field_fore(FIELD *fptr, chtype attribute)
 	FIELD *field = (fptr == NULL)? &_formi_default_field : fptr;
 
 	field->fore = attribute;
+	_formi_dirty_field(field);
 	return E_OK;
 }
 
@@ -597,8 +604,10 @@ set_field_back(FIELD *field, chtype attribute)
 {
 	if (field == NULL)
 		_formi_default_field.back = attribute;
-	else
+	else {
 		field->back = attribute;
+		_formi_dirty_field(field);
+	}
 
 	return E_OK;
 }
@@ -623,8 +632,10 @@ set_field_pad(FIELD *field, int pad)
 {
 	if (field == NULL)
 		_formi_default_field.pad = pad;
-	else
+	else {
 		field->pad = pad;
+		_formi_dirty_field(field);
+	}
 
 	return E_OK;
 }
@@ -767,6 +778,8 @@ _formi_create_field(FIELD *prototype, int rows, int cols, int frow,
 	new->form_col = fcol;
 	new->nrows = nrows;
 	new->link = new;
+	new->drawn = NULL;
+	new->stream = NULL;
 	return new;
 }
 
@@ -812,6 +825,7 @@ new_field(int rows, int cols, int frow, int fcol, int nrows, int nbuf)
 	new->alines->string = NULL;
 	new->alines->hard_ret = FALSE;
 	new->alines->tabs = NULL;
+	new->alines->gen = 0;
 	new->start_line = new->alines;
 	new->cur_line = new->alines;
 	
@@ -923,6 +937,8 @@ free_field(FIELD *field)
 		flink->link = field->link;
 	}
 
+	free(field->drawn);
+	free(field->stream);
 	free(field);
 	return E_OK;
 }
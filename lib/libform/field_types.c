@@ -102,6 +102,9 @@ _formi_create_fieldtype(void)
 	new->char_check = NULL;
 	new->next_choice = NULL;
 	new->prev_choice = NULL;
+	new->stream_new = NULL;
+	new->stream_char = NULL;
+	new->stream_check = NULL;
 
 	return new;
 }
@@ -120,6 +123,10 @@ set_field_type(FIELD *fptr, FIELDTYPE *type, ...)
 	
 	field = (fptr == NULL)? &_formi_default_field : fptr;
 
+	  /* the validation state belongs to the old type */
+	free(field->stream);
+	field->stream = NULL;
+
 	field->type = type;
 	_formi_create_field_args(type, &field->args, &type->link, &args,
 				 &error);
@@ -269,3 +276,22 @@ link_fieldtype(FIELDTYPE *type1, FIELDTYPE *type2)
 	
 	return new;
 }
+
+/*
+ * Set up the incremental validation functions for the given fieldtype.
+ */
+int
+set_fieldtype_stream(FIELDTYPE *fieldtype, char * (*stream_new)(char *),
+		     void (*stream_char)(char *, int, char *),
+		     int (*stream_check)(FIELD *, char *, char *))
+{
+	if ((fieldtype == NULL) || (stream_new == NULL)
+	    || (stream_char == NULL) || (stream_check == NULL))
+		return E_BAD_ARGUMENT;
+
+	fieldtype->stream_new = stream_new;
+	fieldtype->stream_char = stream_char;
+	fieldtype->stream_check = stream_check;
+
+	return E_OK;
+}
@@ -236,6 +236,12 @@ struct _form_field {
 	_FORMI_FIELD_LINES *alines; /* array of the starts and ends of lines */
 	_FORMI_FIELD_LINES *free; /* list of lines available for reuse */
 	FORM_STR *buffers; /* array of buffers for the field */
+	unsigned int gen; /* bumped whenever the field contents change */
+	unsigned int buf0_gen; /* value of gen buffer 0 was built at */
+	struct _formi_drawn_line *drawn; /* what each field row shows */
+	unsigned int drawn_start; /* start_char the rows were drawn at */
+	char *stream; /* incremental validation state of the type */
+	unsigned int stream_gen; /* value of gen the stream state is at */
 };
 
 /* define the types of fields we can have */
@@ -264,6 +270,11 @@ struct _form_fieldtype {
 						choice */
 	int (*prev_choice)(FIELD *, char *); /* function to select prev
 						choice */
+	char * (*stream_new)(char *); /* start incremental validation */
+	void (*stream_char)(char *, int, char *); /* add a char to the
+						     validation state */
+	int (*stream_check)(FIELD *, char *, char *); /* validate the field
+							 using the state */
 };
 	
 /*definition of a form */
@@ -363,6 +374,9 @@ int          set_fieldtype_arg(FIELDTYPE *, char *(*)(va_list *),
 			       void (*)(char *));
 int          set_fieldtype_choice(FIELDTYPE *, int (*)(FIELD *, char *),
 				  int (*)(FIELD *, char *));
+int          set_fieldtype_stream(FIELDTYPE *, char *(*)(char *),
+				  void (*)(char *, int, char *),
+				  int (*)(FIELD *, char *, char *));
 int          set_form_fields(FORM *, FIELD **);
 int          set_form_init(FORM *, Form_Hook);
 int          set_form_opts(FORM *, Form_Options);
@@ -88,6 +88,10 @@ static void
 _formi_do_char_validation(FIELD *field, FIELDTYPE *type, char c, int *ret_val);
 static void
 _formi_do_validation(FIELD *field, FIELDTYPE *type, int *ret_val);
+static void
+_formi_append_sync(FIELD *field, unsigned int old_gen, char c);
+static int
+_formi_stream_sync(FIELD *field);
 static int
 _formi_join_line(FIELD *field, _FORMI_FIELD_LINES **rowp, int direction);
 void
@@ -122,13 +126,15 @@ adjust_ypos(FIELD *field, _FORMI_FIELD_LINES *line);
 static _FORMI_FIELD_LINES *
 copy_row(_FORMI_FIELD_LINES *row);
 static void
-destroy_row_list(_FORMI_FIELD_LINES *start);
+destroy_row_list(_FORMI_FIELD_LINES *start, _FORMI_FIELD_LINES *end);
 
 /*
  * Calculate the cursor y position to make the given row appear on the
  * field.  This may be as simple as just changing the ypos (if at all) but
  * may encompass resetting the start_line of the field to place the line
  * at the bottom of the field.  The field is assumed to be a multi-line one.
+ * Only the rows that can be on the screen above the line are looked at
+ * so the cost does not depend on how far into the buffer the line is.
  */
 static void
 adjust_ypos(FIELD *field, _FORMI_FIELD_LINES *line)
@@ -137,26 +143,19 @@ adjust_ypos(FIELD *field, _FORMI_FIELD_LINES *line)
 	_FORMI_FIELD_LINES *rs;
 	
 	ypos = 0;
-	rs = field->alines;
-	while (rs != line) {
-		rs = rs->next;
+	rs = line;
+	while ((rs->prev != NULL) && (ypos < (field->rows - 1))) {
+		rs = rs->prev;
 		ypos++;
 	}
 
+	  /*
+	   * If the top of the field was not reached then the line is
+	   * off the end of the field, rs is the start_line that puts
+	   * it on the bottom row.
+	   */
 	field->cursor_ypos = ypos;
-	field->start_line = field->alines;
-	if (ypos > (field->rows - 1)) {
-		  /*
-		   * cur_line off the end of the field,
-		   * adjust start_line so fix this.
-		   */
-		field->cursor_ypos = field->rows - 1;
-		ypos = ypos - (field->rows - 1);
-		while (ypos > 0) {
-			ypos--;
-			field->start_line = field->start_line->next;
-		}
-	}
+	field->start_line = rs;
 }
 
 			
@@ -459,16 +458,17 @@ _formi_pos_new_field(FORM *form, unsigned direction, unsigned use_sorted)
 
 /*
  * Destroy the list of line structs passed by freeing all allocated
- * memory.
+ * memory.  The list ends at, but does not include, the row end which
+ * may be NULL to destroy everything up to the end of the list.
  */
 static void
-destroy_row_list(_FORMI_FIELD_LINES *start)
+destroy_row_list(_FORMI_FIELD_LINES *start, _FORMI_FIELD_LINES *end)
 {
 	_FORMI_FIELD_LINES *temp, *row;
 	_formi_tab_t *tt, *tp;
 
 	row = start;
-	while (row != NULL) {
+	while (row != end) {
 		if (row->tabs != NULL) {
 			  /* free up the tab linked list... */
 			tp = row->tabs;
@@ -488,20 +488,85 @@ destroy_row_list(_FORMI_FIELD_LINES *start)
 	}
 }
 
+#ifdef FORMI_FULL_WRAP
+#define WRAP_SHORTCUT FALSE
+#else
+#define WRAP_SHORTCUT TRUE
+#endif
+
+/*
+ * Book keeping for the rows _formi_wrap_field() has backed up.  Rows are
+ * copied just before the wrap first touches them, everything from
+ * frontier on is still exactly as it was before the wrap started.
+ */
+struct wrap_backup {
+	_FORMI_FIELD_LINES *head;	/* first copied row */
+	_FORMI_FIELD_LINES *last;	/* last copied row */
+	_FORMI_FIELD_LINES *frontier;	/* first row not copied yet */
+	_FORMI_FIELD_LINES *loc;	/* the edited row... */
+	_FORMI_FIELD_LINES *loc_copy;	/* ...and its copy */
+	_FORMI_FIELD_LINES *cur_line;	/* cur_line to restore */
+	_FORMI_FIELD_LINES *start_line;	/* start_line to restore */
+	unsigned int last_off;		/* offset of last in the paragraph */
+};
+
+/*
+ * Copy the given row into the backup if the wrap has not touched it
+ * yet.  Returns E_SYSTEM_ERROR if the copy could not be made.
+ */
+static int
+backup_row(struct wrap_backup *bk, _FORMI_FIELD_LINES *row)
+{
+	_FORMI_FIELD_LINES *new;
+
+	if ((row == NULL) || (row != bk->frontier))
+		return E_OK;
+
+	if ((new = copy_row(row)) == NULL)
+		return E_SYSTEM_ERROR;
+
+	if (bk->last == NULL) {
+		bk->head = new;
+		bk->last_off = 0;
+	} else {
+		bk->last->next = new;
+		bk->last_off += bk->last->length;
+	}
+	new->prev = bk->last;
+	bk->last = new;
+
+	if (row == bk->loc)
+		bk->loc_copy = new;
+	if (row == bk->cur_line)
+		bk->cur_line = new;
+	if (row == bk->start_line)
+		bk->start_line = new;
+
+	bk->frontier = row->next;
+	return E_OK;
+}
+
 /*
  * Word wrap the contents of the field's buffer 0 if this is allowed.
  * If the wrap is successful, that is, the row count nor the buffer
  * size is exceeded then the function will return E_OK, otherwise it
  * will return E_REQUEST_DENIED.
+ *
+ * Text never wraps across a hard return so only the paragraph that
+ * holds loc (plus the row above it) can change.  Within the paragraph
+ * the wrap stops as soon as it reaches a row that starts and ends on
+ * the same break points it had before, past that point the layout is
+ * already correct.  Only the rows actually rewrapped are backed up.
  */
 int
 _formi_wrap_field(FIELD *field, _FORMI_FIELD_LINES *loc)
 {
-	int width, wrap_err;
+	int width, wrap_err, track;
 	unsigned int pos, saved_xpos, saved_ypos, saved_cur_xpos;
-	unsigned int saved_row_count;
-	_FORMI_FIELD_LINES *saved_row, *row, *row_backup, *saved_cur_line;
-	_FORMI_FIELD_LINES *saved_start_line, *temp;
+	unsigned int saved_row_count, offset;
+	_FORMI_FIELD_LINES *saved_row, *row, *prev, *back;
+	struct wrap_backup bk;
+	unsigned int hard_left;
 
 	if ((field->opts & O_STATIC) == O_STATIC) {
 		if ((field->rows + field->nrows) == 1) {
@@ -541,40 +606,63 @@ _formi_wrap_field(FIELD *field, _FORMI_FIELD_LINES *loc)
 	saved_cur_xpos = field->cursor_xpos;
 	saved_ypos = field->cursor_ypos;
 	saved_row_count = field->row_count;
-	
+
 	  /*
-	   * Save a copy of the lines affected, just in case things
+	   * The wrap ends when it passes the hard return at the end of
+	   * the paragraph loc is in, the rows after that are left alone.
+	   * hard_left counts the hard returns to pass before that one,
+	   * there is one if the row above loc ends the paragraph before.
+	   * Working this out as the wrap goes, rather than finding the
+	   * end of the paragraph first, keeps the cost of a wrap down to
+	   * the rows it changes.
+	   */
+	hard_left = ((saved_row != loc) && (saved_row->hard_ret == TRUE));
+
+	  /*
+	   * Rows are saved as they are reached, just in case things
 	   * don't work out.
 	   */
-	if ((row_backup = copy_row(row)) == NULL)
-		return E_SYSTEM_ERROR;
+	bk.head = NULL;
+	bk.last = NULL;
+	bk.frontier = saved_row;
+	bk.loc = loc;
+	bk.loc_copy = NULL;
+	bk.cur_line = field->cur_line;
+	bk.start_line = field->start_line;
+	bk.last_off = 0;
 
-	temp = row_backup;
-	row = row->next;
+	  /*
+	   * offset is the position of the start of row in the paragraph
+	   * text, bk.last_off is the same for the last row backed up.
+	   * Every row above row is final.  The rest of the paragraph is
+	   * already wrapped once row, past the edited row, starts and ends
+	   * on the same break points as one of the original rows and only
+	   * original rows follow it.  That is either the first row not
+	   * backed up yet, or a row that covers exactly the last one backed
+	   * up.  Tracking is dropped if find_sow() ever backs up a row.
+	   * Defining FORMI_FULL_WRAP turns this off, the tests use it to get
+	   * the layout a wrap to the end of the paragraph gives.
+	   */
+	offset = 0;
+	track = WRAP_SHORTCUT;
 
-	saved_cur_line = temp;
-	saved_start_line = temp;
-	
 	while (row != NULL) {
-		if ((temp->next = copy_row(row)) == NULL) {
-			  /* a row copy failed... free up allocations */
-			destroy_row_list(row_backup);
-			return E_SYSTEM_ERROR;
+		if ((track == TRUE) && (bk.loc_copy != NULL)) {
+			if ((row == bk.frontier) &&
+			    (offset == bk.last_off + bk.last->length))
+				break;
+			if ((bk.last != bk.loc_copy) &&
+			    (row->next == bk.frontier) &&
+			    (offset == bk.last_off) &&
+			    (row->length == bk.last->length))
+				break;
 		}
 
-		temp->next->prev = temp;
-		temp = temp->next;
-		
-		if (row == field->start_line)
-			saved_start_line = temp;
-		if (row == field->cur_line)
-			saved_cur_line = temp;
-
-		row = row->next;
-	}
+		if (backup_row(&bk, row) != E_OK) {
+			wrap_err = E_SYSTEM_ERROR;
+			goto restore_and_exit;
+		}
 
-	row = saved_row;
-	while (row != NULL) {
 		pos = row->length - 1;
 		if (row->expanded < width) {
 			  /* line may be too short, try joining some lines */
@@ -584,6 +672,10 @@ _formi_wrap_field(FIELD *field, _FORMI_FIELD_LINES *loc)
 				 * and it is not the last, we cannot join
 				 * anything to it.
 				 */
+				if (hard_left == 0)
+					break;
+				hard_left--;
+				offset += row->length;
 				row = row->next;
 				continue;
 			}
@@ -596,6 +688,11 @@ _formi_wrap_field(FIELD *field, _FORMI_FIELD_LINES *loc)
 				break;
 			}
 
+			if (backup_row(&bk, row->next) != E_OK) {
+				wrap_err = E_SYSTEM_ERROR;
+				goto restore_and_exit;
+			}
+
 			if (_formi_join_line(field, &row,
 					     JOIN_NEXT_NW) == E_OK) {
 				continue;
@@ -619,9 +716,21 @@ _formi_wrap_field(FIELD *field, _FORMI_FIELD_LINES *loc)
 
 			if ((!isblank((unsigned char)row->string[pos])) &&
 			    ((field->opts & O_WRAP) == O_WRAP)) {
-				if (!isblank((unsigned char)row->string[pos - 1]))
+				if (!isblank((unsigned char)row->string[pos - 1])) {
+					prev = row;
 					pos = find_sow((unsigned int) pos,
 						       &row);
+					  /*
+					   * The word can start rows back,
+					   * even before a hard return.
+					   */
+					for (back = row; back != prev;
+					     back = back->next) {
+						track = FALSE;
+						if (back->hard_ret == TRUE)
+							hard_left++;
+					}
+				}
 				/*
 				 * If we cannot split the line then return
 				 * NO_ROOM so the driver can tell that it
@@ -652,13 +761,23 @@ _formi_wrap_field(FIELD *field, _FORMI_FIELD_LINES *loc)
 			    (pos != row->length - 1))
 				pos++;
 
+			prev = row;
 			if (split_line(field, FALSE, pos, &row) != E_OK) {
 				wrap_err = E_REQUEST_DENIED;
 				goto restore_and_exit;
 			}
-		} else
+			if (row != prev)
+				offset += prev->length;
+		} else {
 			  /* line is exactly the right length, do next one */
+			if (row->hard_ret == TRUE) {
+				if (hard_left == 0)
+					break;
+				hard_left--;
+			}
+			offset += row->length;
 			row = row->next;
+		}
 	}
 
 	  /* Check if we have not run out of room */
@@ -669,25 +788,35 @@ _formi_wrap_field(FIELD *field, _FORMI_FIELD_LINES *loc)
 		wrap_err = E_REQUEST_DENIED;
 
 	  restore_and_exit:
-		if (saved_row->prev == NULL) {
-			field->alines = row_backup;
-		} else {
-			saved_row->prev->next = row_backup;
-			row_backup->prev = saved_row->prev;
+		  /*
+		   * Swap the rows before the frontier for the copies,
+		   * the rest were never touched.
+		   */
+		if (bk.head != NULL) {
+			row = saved_row->prev;
+			destroy_row_list(saved_row, bk.frontier);
+			if (row == NULL) {
+				field->alines = bk.head;
+			} else {
+				row->next = bk.head;
+				bk.head->prev = row;
+			}
+			bk.last->next = bk.frontier;
+			if (bk.frontier != NULL)
+				bk.frontier->prev = bk.last;
 		}
 
 		field->row_xpos = saved_xpos;
 		field->cursor_xpos = saved_cur_xpos;
 		field->cursor_ypos = saved_ypos;
 		field->row_count = saved_row_count;
-		field->start_line = saved_start_line;
-		field->cur_line = saved_cur_line;
+		field->start_line = bk.start_line;
+		field->cur_line = bk.cur_line;
 
-		destroy_row_list(saved_row);
 		return wrap_err;
 	}
 
-	destroy_row_list(row_backup);
+	destroy_row_list(bk.head, NULL);
 	return E_OK;
 }
 
@@ -737,6 +866,7 @@ _formi_join_line(FIELD *field, _FORMI_FIELD_LINES **rowp, int direction)
 		}
 
 		strcat(row->string, row->next->string);
+		row->gen = field->gen;
 		old_len = row->length;
 		row->length += row->next->length;
 		if (row->length > 0)
@@ -807,6 +937,7 @@ _formi_join_line(FIELD *field, _FORMI_FIELD_LINES **rowp, int direction)
 		}
 
 		strcat(saved->string, row->string);
+		saved->gen = field->gen;
 		old_len = saved->length;
 		saved->length += row->length;
 		if (saved->length > 0)
@@ -845,7 +976,7 @@ _formi_join_line(FIELD *field, _FORMI_FIELD_LINES **rowp, int direction)
 	   */
 	saved = field->start_line;
 	count = 0;
-	while (saved->next != NULL) {
+	while ((saved->next != NULL) && (count <= field->cursor_ypos)) {
 		if (saved == row)
 			break;
 		count++;
@@ -910,6 +1041,8 @@ split_line(FIELD *field, bool hard_split, unsigned pos,
 		new_line->hard_ret = FALSE;
 		new_line->tabs = NULL;
 	}
+	new_line->gen = field->gen;
+	row->gen = field->gen;
 
 	_formi_dbg_printf("%s: enter: length = %d, expanded = %d\n", __func__,
 	    row->length, row->expanded);
@@ -1492,7 +1625,21 @@ _formi_find_pages(FORM *form)
 }
 
 /*
- * Completely redraw the field of the given form.
+ * Forget what is on the screen for the field so the next redraw
+ * repaints every row of it.
+ */
+void
+_formi_dirty_field(FIELD *field)
+{
+	free(field->drawn);
+	field->drawn = NULL;
+}
+
+/*
+ * Redraw the field of the given form.  The line and generation drawn
+ * on each row of the field is remembered, rows still showing the same
+ * generation of the same line are left alone so an edit only repaints
+ * the rows it changed.
  */
 void
 _formi_redraw_field(FORM *form, int field)
@@ -1502,6 +1649,7 @@ _formi_redraw_field(FORM *form, int field)
 	char *str, c;
 	FIELD *cur;
 	_FORMI_FIELD_LINES *row;
+	struct _formi_drawn_line *drawn;
 #ifdef DEBUG
 	char buffer[100];
 #endif
@@ -1512,8 +1660,20 @@ _formi_redraw_field(FORM *form, int field)
 	start = 0;
 	line = 0;
 
+	  /* a horizontal scroll moves every row */
+	if (cur->start_char != cur->drawn_start)
+		_formi_dirty_field(cur);
+	if (cur->drawn == NULL)
+		cur->drawn = calloc(cur->rows, sizeof(*cur->drawn));
+	cur->drawn_start = cur->start_char;
+	drawn = cur->drawn;
+
 	for (row = cur->start_line; ((row != NULL) && (line < cur->rows));
 	     row = row->next, line++) {
+		if ((drawn != NULL) && (drawn[line].valid == TRUE) &&
+		    (drawn[line].row == row) && (drawn[line].gen == row->gen))
+			continue;
+
 		wmove(form->scrwin, (int) (cur->form_row + line),
 		      (int) cur->form_col);
 		if ((cur->rows + cur->nrows) == 1) {
@@ -1671,9 +1831,19 @@ _formi_redraw_field(FORM *form, int field)
 		wattrset(form->scrwin, cur->back);
 		for (i = 0; i < post; i++)
 			waddch(form->scrwin, cur->pad);
+
+		if (drawn != NULL) {
+			drawn[line].row = row;
+			drawn[line].gen = row->gen;
+			drawn[line].valid = TRUE;
+		}
 	}
 
 	for (i = line; i < cur->rows; i++) {
+		if ((drawn != NULL) && (drawn[i].valid == TRUE) &&
+		    (drawn[i].row == NULL))
+			continue;
+
 		wmove(form->scrwin, (int) (cur->form_row + i),
 		      (int) cur->form_col);
 
@@ -1682,6 +1852,11 @@ _formi_redraw_field(FORM *form, int field)
 		for (j = 0; j < cur->cols; j++) {
 			waddch(form->scrwin, cur->pad);
 		}
+
+		if (drawn != NULL) {
+			drawn[i].row = NULL;
+			drawn[i].valid = TRUE;
+		}
 	}
 
 	wattrset(form->scrwin, cur->back);
@@ -1732,8 +1907,10 @@ _formi_draw_page(FORM *form)
 	wclear(form->scrwin);
 
 	for (i = form->page_starts[form->page].first;
-	     i <= form->page_starts[form->page].last; i++)
+	     i <= form->page_starts[form->page].last; i++) {
+		_formi_dirty_field(form->fields[i]);
 		_formi_redraw_field(form, i);
+	}
 
 	return E_OK;
 }
@@ -1746,10 +1923,15 @@ _formi_add_char(FIELD *field, unsigned int pos, char c)
 {
 	char *new, old_c;
 	unsigned int new_size;
-	int status;
+	int status, append;
 	_FORMI_FIELD_LINES *row, *temp, *next_temp;
 
+	field->gen++;
 	row = field->cur_line;
+	row->gen = field->gen;
+
+	  /* adding to the end of the last line only appends to buffer 0 */
+	append = ((row->next == NULL) && (pos == row->length));
 
 	  /*
 	   * If buffer has not had a string before, set it to a blank
@@ -1798,6 +1980,8 @@ _formi_add_char(FIELD *field, unsigned int pos, char c)
 
 		row->length = 0;
 		row->string[0] = '\0';
+		row->gen = field->gen;
+		append = FALSE;
 		pos = 0;
 		field->start_char = 0;
 		field->start_line = row;
@@ -1819,7 +2003,12 @@ _formi_add_char(FIELD *field, unsigned int pos, char c)
 
 		if (row->length + 2
 		    >= row->allocated) {
-			new_size = row->allocated + 16 - (row->allocated % 16);
+			  /*
+			   * grow geometrically so typing into a long
+			   * line does not realloc on every character.
+			   */
+			new_size = row->allocated + row->allocated / 2;
+			new_size += 16 - (new_size % 16);
 			if ((new = realloc(row->string,
 						  (size_t) new_size )) == NULL)
 				return E_SYSTEM_ERROR;
@@ -1885,6 +2074,11 @@ _formi_add_char(FIELD *field, unsigned int pos, char c)
 		}
 
 		_formi_calculate_tabs(row);
+		if (row->length > 0)
+			row->expanded = _formi_tab_expanded_length(
+				row->string, 0, row->length - 1);
+		else
+			row->expanded = 0;
 
 		_formi_wrap_field(field, row);
 		  /*
@@ -1897,6 +2091,8 @@ _formi_add_char(FIELD *field, unsigned int pos, char c)
 
 	} else {
 		field->buf0_status = TRUE;
+		if (append)
+			_formi_append_sync(field, field->gen - 1, c);
 		field->row_xpos++;
 		if ((field->rows + field->nrows) == 1) {
 			status = _formi_set_cursor_xpos(field, FALSE);
@@ -2083,6 +2279,16 @@ _formi_manipulate_field(FORM *form, int c)
 	saved = '\0';
 	row = cur->cur_line;
 
+	  /* the editing requests change the field contents */
+	if ((c >= REQ_NEW_LINE) && (c <= REQ_CLR_FIELD)) {
+		cur->gen++;
+		row->gen = cur->gen;
+		  /* these may change lines other than the current one */
+		if ((c == REQ_DEL_LINE) || (c == REQ_DEL_WORD) ||
+		    (c == REQ_CLR_EOF) || (c == REQ_CLR_FIELD))
+			_formi_dirty_field(cur);
+	}
+
 	switch (c) {
 	case REQ_RIGHT_CHAR:
 		  /*
@@ -2473,6 +2679,18 @@ _formi_manipulate_field(FORM *form, int c)
 		cur->cur_line->hard_ret = TRUE;
 		cur->cursor_xpos = 0;
 		cur->row_xpos = 0;
+		  /*
+		   * the paragraph above just got shorter, let it wrap
+		   * now because later edits only wrap their own
+		   * paragraph.  The wrap can pull rows up so work out
+		   * where the cursor row is on the field again.
+		   */
+		if (cur->cur_line->prev != NULL) {
+			if ((status = _formi_wrap_field(cur,
+			    cur->cur_line->prev)) != E_OK)
+				return status;
+			adjust_ypos(cur, cur->cur_line);
+		}
 		break;
 		
 	case REQ_INS_CHAR:
@@ -2605,11 +2823,16 @@ _formi_manipulate_field(FORM *form, int c)
 		
 		if ((cur->rows + cur->nrows) > 1) {
 			if (_formi_wrap_field(cur, row) != E_OK) {
+				  /* the failed wrap put back copies of the rows */
+				row = cur->cur_line;
 				memmove(&row->string[start + 1],
 				      &row->string[start],
 				      (size_t) (end - start));
 				row->length++;
 				row->string[start] = saved;
+				row->string[row->length] = '\0';
+				row->expanded = _formi_tab_expanded_length(
+					row->string, 0, row->length - 1);
 				_formi_wrap_field(cur, row);
 				return E_REQUEST_DENIED;
 			}
@@ -2700,12 +2923,16 @@ _formi_manipulate_field(FORM *form, int c)
 			}
 			
 			if ((_formi_wrap_field(cur, row) != E_OK)) {
+				  /* row was swapped for its copy, as above */
+				row = cur->cur_line;
 				memmove(&row->string[start],
 				      &row->string[start - 1],
 				      (size_t) (end - start));
 				row->length++;
 				row->string[start - 1] = saved;
 				row->string[row->length] = '\0';
+				row->expanded = _formi_tab_expanded_length(
+					row->string, 0, row->length - 1);
 				_formi_wrap_field(cur, row);
 				return E_REQUEST_DENIED;
 			}
@@ -3053,7 +3280,12 @@ _formi_do_validation(FIELD *field, FIELDTYPE *type, int *ret_val)
 	} else {
 		if (type->field_check == NULL)
 			*ret_val = E_OK;
-		else {
+		else if ((type->stream_check != NULL) && (type == field->type)
+			 && (_formi_stream_sync(field) == TRUE)) {
+			if (type->stream_check(field, field->stream,
+					       field_buffer(field, 0)) == TRUE)
+				*ret_val = E_OK;
+		} else {
 			if (type->field_check(field, field_buffer(field, 0))
 			    == TRUE)
 				*ret_val = E_OK;
@@ -3061,6 +3293,86 @@ _formi_do_validation(FIELD *field, FIELDTYPE *type, int *ret_val)
 	}
 }
 
+/*
+ * The character c has been appended to the end of the field contents.
+ * If buffer 0 and the validation state of the field type were up to
+ * date before that then bring them along with the append instead of
+ * leaving them to be rebuilt from the whole field.
+ */
+static void
+_formi_append_sync(FIELD *field, unsigned int old_gen, char c)
+{
+	FORM_STR *buf;
+	FIELDTYPE *type;
+	char *new;
+	unsigned int new_size;
+
+	  /* linked fields share the lines but not the generation */
+	if (field->link != field)
+		return;
+
+	buf = &field->buffers[0];
+	if ((field->buf0_gen == old_gen) && (buf->string != NULL)) {
+		if (buf->length + 2 > buf->allocated) {
+			new_size = buf->allocated + buf->allocated / 2;
+			new_size += 16 - (new_size % 16);
+			if ((new = realloc(buf->string, (size_t) new_size))
+			    == NULL)
+				return;
+			buf->string = new;
+			buf->allocated = new_size;
+		}
+		buf->string[buf->length++] = c;
+		buf->string[buf->length] = '\0';
+		field->buf0_gen = field->gen;
+	}
+
+	type = field->type;
+	if ((field->stream != NULL) && (field->stream_gen == old_gen)) {
+		type->stream_char(field->stream, (int)(unsigned char) c,
+				  field->args);
+		field->stream_gen = field->gen;
+	}
+}
+
+/*
+ * Make sure the validation state of the field type covers the current
+ * contents of buffer 0, running the whole buffer through it again if the
+ * field changed other than by appending.  Return FALSE if there is no
+ * state to use.
+ */
+static int
+_formi_stream_sync(FIELD *field)
+{
+	FIELDTYPE *type;
+	char *p;
+
+	  /*
+	   * A reformatted buffer has line breaks put in where the field
+	   * wraps so an append to the field is not an append to it.
+	   */
+	if ((field->link != field)
+	    || ((field->opts & O_REFORMAT) == O_REFORMAT))
+		return FALSE;
+
+	if ((field->stream != NULL) && (field->stream_gen == field->gen))
+		return TRUE;
+
+	if (_formi_sync_buffer(field) != E_OK)
+		return FALSE;
+
+	type = field->type;
+	free(field->stream);
+	if ((field->stream = type->stream_new(field->args)) == NULL)
+		return FALSE;
+
+	for (p = field->buffers[0].string; *p != '\0'; p++)
+		type->stream_char(field->stream, (int)(unsigned char) *p,
+				  field->args);
+	field->stream_gen = field->gen;
+	return TRUE;
+}
+
 /*
  * Select the next/previous choice for the field, the driver command
  * selecting the direction will be passed in c.  Return 1 if a choice
@@ -3141,7 +3453,6 @@ static int
 field_sort_compare(const void *one, const void *two)
 {
 	const FIELD *a, *b;
-	int tl;
 	
 	a = *(const FIELD **) one;
 	b = *(const FIELD **) two;
@@ -3159,13 +3470,18 @@ field_sort_compare(const void *one, const void *two)
 	if (a->page != b->page)
 		return ((a->page > b->page)? 1 : -1);
 
-	tl = _formi_top_left(a->parent, a->index, b->index);
-
 	  /*
 	   * sort fields left to right, top to bottom so the top left is
 	   * the lesser value....
 	   */
-	return ((tl == a->index)? -1 : 1);
+	if (a->form_row != b->form_row)
+		return ((a->form_row > b->form_row)? 1 : -1);
+
+	if (a->form_col != b->form_col)
+		return ((a->form_col > b->form_col)? 1 : -1);
+
+	  /* fields in the same place keep their form order */
+	return ((a->index > b->index)? 1 : -1);
 }
 	
 /*
@@ -3194,13 +3510,47 @@ _formi_sort_fields(FORM *form)
 }
 
 /*
- * Set the neighbours for all the fields in the given form.
+ * Return the field of the sorted fields from start up to (but not
+ * including) end, which all sit on the same row, that is closest to the
+ * column col.  If two fields are equally close the left one wins.
+ */
+static FIELD *
+nearest_field(FIELD **sorted, int start, int end, unsigned int col)
+{
+	int lo, hi, mid;
+
+	  /* find the first field at or right of col */
+	lo = start;
+	hi = end;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (sorted[mid]->form_col < col)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == end)
+		return sorted[end - 1];
+	if (lo == start)
+		return sorted[start];
+	if ((col - sorted[lo - 1]->form_col) <= (sorted[lo]->form_col - col))
+		return sorted[lo - 1];
+	return sorted[lo];
+}
+
+/*
+ * Set the neighbours for all the fields in the given form.  The left and
+ * right neighbours are the fields either side in the sorted order.  The
+ * sorted fields are split into rows, a run of fields on the same row of
+ * the same page, and the up and down neighbours are the fields closest in
+ * column on the rows before and after.
  */
 void
 _formi_stitch_fields(FORM *form)
 {
-	int above_row, below_row, end_above, end_below, cur_row, real_end;
-	FIELD *cur, *above, *below;
+	FIELD **sorted, *cur;
+	int *rows, nrows, count, i, r;
 
 	  /*
 	   * check if the sorted fields circle queue is empty, just
@@ -3209,104 +3559,48 @@ _formi_stitch_fields(FORM *form)
 	if (TAILQ_EMPTY(&form->sorted_fields))
 		return;
 	
-	  /* initially nothing is above..... */
-	above_row = -1;
-	end_above = TRUE;
-	above = NULL;
-
-	  /* set up the first field as the current... */
-	cur = TAILQ_FIRST(&form->sorted_fields);
-	cur_row = cur->form_row;
-	
-	  /* find the first field on the next row if any */
-	below = TAILQ_NEXT(cur, glue);
-	below_row = -1;
-	end_below = TRUE;
-	real_end = TRUE;
-	while (below != NULL) {
-		if (below->form_row != cur_row) {
-			below_row = below->form_row;
-			end_below = FALSE;
-			real_end = FALSE;
-			break;
-		}
-		below = TAILQ_NEXT(below, glue);
+	sorted = malloc(form->field_count * sizeof(*sorted));
+	rows = malloc((form->field_count + 1) * sizeof(*rows));
+	if ((sorted == NULL) || (rows == NULL)) {
+		free(sorted);
+		free(rows);
+		return;
 	}
 
-	  /* walk the sorted fields, setting the neighbour pointers */
-	while (cur != NULL) {
-		if (cur == TAILQ_FIRST(&form->sorted_fields))
-			cur->left = NULL;
-		else
-			cur->left = TAILQ_PREV(cur, _formi_sort_head, glue);
-
-		if (cur == TAILQ_LAST(&form->sorted_fields, _formi_sort_head))
-			cur->right = NULL;
-		else
-			cur->right = TAILQ_NEXT(cur, glue);
-
-		if (end_above == TRUE)
-			cur->up = NULL;
-		else {
-			cur->up = above;
-			above = TAILQ_NEXT(above, glue);
-			if (above_row != above->form_row) {
-				end_above = TRUE;
-				above_row = above->form_row;
-			}
-		}
-
-		if (end_below == TRUE)
-			cur->down = NULL;
-		else {
-			cur->down = below;
-			below = TAILQ_NEXT(below, glue);
-			if (below == NULL) {
-				end_below = TRUE;
-				real_end = TRUE;
-			} else if (below_row != below->form_row) {
-				end_below = TRUE;
-				below_row = below->form_row;
-			}
-		}
-
-		cur = TAILQ_NEXT(cur, glue);
-		if ((cur != NULL)
-		    && (cur_row != cur->form_row)) {
-			cur_row = cur->form_row;
-			if (end_above == FALSE) {
-				for (; above !=
-				    TAILQ_FIRST(&form->sorted_fields);
-				    above = TAILQ_NEXT(above, glue)) {
-					if (above->form_row != above_row) {
-						above_row = above->form_row;
-						break;
-					}
-				}
-			} else if (above == NULL) {
-				above = TAILQ_FIRST(&form->sorted_fields);
-				end_above = FALSE;
-				above_row = above->form_row;
-			} else
-				end_above = FALSE;
-
-			if (end_below == FALSE) {
-				while (below_row == below->form_row) {
-					below = TAILQ_NEXT(below, glue);
-					if (below == NULL) {
-						real_end = TRUE;
-						end_below = TRUE;
-						break;
-					}
-				}
+	  /* index the start of each row in the sorted fields */
+	count = 0;
+	nrows = 0;
+	TAILQ_FOREACH(cur, &form->sorted_fields, glue) {
+		if ((count == 0) || (cur->page != sorted[count - 1]->page)
+		    || (cur->form_row != sorted[count - 1]->form_row))
+			rows[nrows++] = count;
+		sorted[count++] = cur;
+	}
+	rows[nrows] = count;
+
+	for (r = 0; r < nrows; r++) {
+		for (i = rows[r]; i < rows[r + 1]; i++) {
+			cur = sorted[i];
+			cur->left = (i == 0) ? NULL : sorted[i - 1];
+			cur->right = (i == count - 1) ? NULL : sorted[i + 1];
+
+			if (r == 0)
+				cur->up = NULL;
+			else
+				cur->up = nearest_field(sorted, rows[r - 1],
+							rows[r], cur->form_col);
 
-				if (below != NULL)
-					below_row = below->form_row;
-			} else if (real_end == FALSE)
-				end_below = FALSE;
-			
+			if (r == nrows - 1)
+				cur->down = NULL;
+			else
+				cur->down = nearest_field(sorted, rows[r + 1],
+							  rows[r + 2],
+							  cur->form_col);
 		}
 	}
+
+	free(sorted);
+	free(rows);
 }
 
 /*
@@ -3383,7 +3677,7 @@ _formi_calculate_tabs(_FORMI_FIELD_LINES *row)
 	for (i = 0, j = 0; i < row->length; i++, j++) {
 		if (row->string[i] == '\t') {
 			if (*tsp == NULL) {
-				if ((*tsp = malloc(sizeof(*tsp))) == NULL)
+				if ((*tsp = malloc(sizeof(**tsp))) == NULL)
 					return;
 				(*tsp)->back = old_ts;
 				(*tsp)->fwd = NULL;
@@ -3523,14 +3817,17 @@ tab_fit_len(_FORMI_FIELD_LINES *row, unsigned int width)
 /*
  * Sync the field line structures with the contents of buffer 0 for that
  * field.  We do this by walking all the line structures and concatenating
- * all the strings into one single string in buffer 0.
+ * all the strings into one single string in buffer 0.  The field
+ * generation tells us if anything changed since buffer 0 was last built,
+ * if not then the buffer is left alone.  Linked fields share their lines
+ * so they are always rebuilt.
  */
 int
 _formi_sync_buffer(FIELD *field) 
 {
 	_FORMI_FIELD_LINES *line;
-	char *nstr, *tmp;
-	unsigned length;
+	char *nstr;
+	size_t length, pos;
 
 	if (field->alines == NULL)
 		return E_BAD_ARGUMENT;
@@ -3538,40 +3835,36 @@ _formi_sync_buffer(FIELD *field)
 	if (field->alines->string == NULL)
 		return E_BAD_ARGUMENT;
 
-	  /*
-	   * init nstr up front, just in case there are no line contents,
-	   * this could happen if the field just contains hard returns.
-	   */
-	if ((nstr = malloc(sizeof(*nstr))) == NULL)
-		return E_SYSTEM_ERROR;
-	nstr[0] = '\0';
-	
-	line = field->alines;
-	length = 1; /* allow for terminating null */
-	
-	while (line != NULL) {
-		if (line->length != 0) {
-			if ((tmp = realloc(nstr,
-					   (size_t) (length + line->length)))
-			    == NULL) {
-				if (nstr != NULL)
-					free(nstr);
-				return (E_SYSTEM_ERROR);
-			}
+	if ((field->buf0_gen == field->gen) && (field->link == field)
+	    && (field->buffers[0].string != NULL))
+		return E_OK;
 
-			nstr = tmp;
-			strcat(nstr, line->string);
-			length += line->length;
-		}
+	  /* size the whole buffer first so it is only allocated once */
+	length = 0;
+	for (line = field->alines; line != NULL; line = line->next)
+		length += line->length;
 
-		line = line->next;
+	if (field->buffers[0].allocated >= length + 1)
+		nstr = field->buffers[0].string;
+	else {
+		if ((nstr = malloc(length + 1)) == NULL)
+			return E_SYSTEM_ERROR;
+		free(field->buffers[0].string);
+		field->buffers[0].string = nstr;
+		field->buffers[0].allocated = length + 1;
 	}
 
-	if (field->buffers[0].string != NULL)
-		free(field->buffers[0].string);
-	field->buffers[0].allocated = length;
-	field->buffers[0].length = length - 1;
-	field->buffers[0].string = nstr;
+	pos = 0;
+	for (line = field->alines; line != NULL; line = line->next) {
+		if (line->length != 0) {
+			memcpy(&nstr[pos], line->string, line->length);
+			pos += line->length;
+		}
+	}
+	nstr[pos] = '\0';
+
+	field->buffers[0].length = (unsigned int) length;
+	field->buf0_gen = field->gen;
 	return E_OK;
 }
 
@@ -93,6 +93,15 @@ struct _formi_field_lines
 	char *string;
 	unsigned char hard_ret; /* line contains hard return */
 	_formi_tab_t *tabs;
+	unsigned int gen; /* field gen the line last changed at */
+};
+
+/* what _formi_redraw_field last put on a row of the field */
+struct _formi_drawn_line
+{
+	_FORMI_FIELD_LINES *row; /* line drawn, NULL for padding */
+	unsigned int gen; /* gen of the line when it was drawn */
+	unsigned char valid; /* row and gen are meaningful */
 };
 
 
@@ -103,6 +112,8 @@ int
 _formi_add_char(FIELD *cur, unsigned pos, char c);
 void
 _formi_calculate_tabs(_FORMI_FIELD_LINES *row);
+void
+_formi_dirty_field(FIELD *field);
 int
 _formi_draw_page(FORM *form);
 int
@@ -29,10 +29,10 @@
  *
  */
 
+#include <sys/param.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
-#include <strings.h>
 #include "form.h"
 #include "internals.h"
 
@@ -46,12 +46,28 @@ trim_blanks(char *field);
  * The enum type handling.
  */
 
+/*
+ * A choice with the surrounding blanks trimmed (and folded to lower case
+ * when matching ignores case).  The keys are kept sorted so the choices
+ * a string matches form a contiguous run of the array.
+ */
+typedef struct
+{
+	char *key;
+	unsigned len;
+	unsigned index;		/* position of the choice in choices */
+} enum_key;
+
 typedef struct 
 {
 	char **choices;
 	unsigned num_choices;
 	bool ignore_case;
 	bool exact;
+	enum_key *keys;		/* trimmed choices, sorted */
+	char *key_space;	/* storage for the key strings */
+	unsigned *min_index;	/* tree of the lowest index in a key range */
+	unsigned references;
 } enum_args;
 
 /*
@@ -75,6 +91,138 @@ trim_blanks(char *field)
 	return i;
 }
 
+/*
+ * Work out the part of the string that takes part in a match, pass back
+ * the index of the start of it and return the length.  This deliberately
+ * mirrors the old scan: an empty string yields a one character key made
+ * of the terminating nul and a string of only blanks yields no key.
+ */
+static unsigned
+trimmed_key(char *this, unsigned *start)
+{
+	unsigned end;
+
+	*start = _formi_skip_blanks(this, 0);
+	end = trim_blanks(this);
+
+	if (end >= *start)
+		return (unsigned) (strlen(&this[*start])
+				   - strlen(&this[end]) + 1);
+	else
+		return 0;
+}
+
+/*
+ * Order the keys by their bytes, a key sorts before the keys it is a
+ * prefix of, equal keys are kept in the order of the choices.
+ */
+static int
+compare_keys(const void *a, const void *b)
+{
+	const enum_key *ka = a, *kb = b;
+	int ret;
+
+	ret = memcmp(ka->key, kb->key, MIN(ka->len, kb->len));
+	if (ret != 0)
+		return ret;
+	if (ka->len != kb->len)
+		return (ka->len < kb->len) ? -1 : 1;
+	if (ka->index != kb->index)
+		return (ka->index < kb->index) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Compare the first len characters of the key with the test string,
+ * folding the test string if required.  A key shorter than the test
+ * string sorts before it, a key the test string is a prefix of compares
+ * equal.
+ */
+static int
+compare_prefix(enum_key *key, const char *this, unsigned len,
+	       bool ignore_case)
+{
+	unsigned i, n;
+	unsigned char kc, tc;
+
+	n = MIN(key->len, len);
+	for (i = 0; i < n; i++) {
+		kc = (unsigned char) key->key[i];
+		tc = (unsigned char) this[i];
+		if (ignore_case)
+			tc = (unsigned char) tolower(tc);
+		if (kc != tc)
+			return (kc < tc) ? -1 : 1;
+	}
+
+	return (key->len < len) ? -1 : 0;
+}
+
+/*
+ * Build the sorted keys for the choices along with a tree holding the
+ * lowest choice index of each range of keys.  Return FALSE if memory
+ * runs out.
+ */
+static bool
+build_enum_keys(enum_args *ea)
+{
+	unsigned i, j, n, start, len, total;
+	char *space;
+
+	n = ea->num_choices;
+	if (n == 0)
+		return TRUE;
+
+	total = 0;
+	for (i = 0; i < n; i++)
+		total += trimmed_key(ea->choices[i], &start);
+
+	if ((ea->keys = malloc(n * sizeof(*ea->keys))) == NULL)
+		return FALSE;
+	if ((ea->key_space = malloc(total + 1)) == NULL)
+		return FALSE;
+	ea->min_index = malloc(2 * n * sizeof(*ea->min_index));
+	if (ea->min_index == NULL)
+		return FALSE;
+
+	space = ea->key_space;
+	for (i = 0; i < n; i++) {
+		len = trimmed_key(ea->choices[i], &start);
+		for (j = 0; j < len; j++) {
+			space[j] = ea->choices[i][start + j];
+			if (ea->ignore_case)
+				space[j] = (char) tolower(
+				    (unsigned char) space[j]);
+		}
+		ea->keys[i].key = space;
+		ea->keys[i].len = len;
+		ea->keys[i].index = i;
+		space += len;
+	}
+
+	qsort(ea->keys, n, sizeof(*ea->keys), compare_keys);
+
+	  /* leaves live at n..2n-1, node k covers nodes 2k and 2k+1 */
+	for (i = 0; i < n; i++)
+		ea->min_index[n + i] = ea->keys[i].index;
+	for (i = n - 1; i > 0; i--)
+		ea->min_index[i] = MIN(ea->min_index[2 * i],
+				       ea->min_index[2 * i + 1]);
+
+	return TRUE;
+}
+
+/*
+ * Free the storage built by build_enum_keys.
+ */
+static void
+free_enum_keys(enum_args *ea)
+{
+	free(ea->keys);
+	free(ea->key_space);
+	free(ea->min_index);
+}
+
 /*
  * Create the enum arguments structure from the given args.  Return NULL
  * if the call fails, otherwise return a pointer to the structure allocated.
@@ -92,6 +240,10 @@ create_enum_args(va_list *args)
 	new->choices = va_arg(*args, char **);
 	new->ignore_case = (va_arg(*args, int)) ? TRUE : FALSE;
 	new->exact = (va_arg(*args, int)) ? TRUE : FALSE;
+	new->keys = NULL;
+	new->key_space = NULL;
+	new->min_index = NULL;
+	new->references = 1;
 
 	_formi_dbg_printf("%s: ignore_case %d, no_blanks %d\n", __func__,
 	    new->ignore_case, new->exact);
@@ -108,6 +260,12 @@ create_enum_args(va_list *args)
 	_formi_dbg_printf("%s: have %u choices\n", __func__,
 	    new->num_choices);
 
+	if (build_enum_keys(new) == FALSE) {
+		free_enum_keys(new);
+		free(new);
+		return NULL;
+	}
+
 	return (void *) new;
 }
 
@@ -117,14 +275,9 @@ create_enum_args(va_list *args)
 static char *
 copy_enum_args(char *args)
 {
-	enum_args *new;
-
-	new = malloc(sizeof(*new));
-
-	if (new != NULL)
-		memcpy(new, args, sizeof(*new));
+	((enum_args *) (void *) args)->references++;
 
-	return (void *) new;
+	return (void *) args;
 }
 
 /*
@@ -133,85 +286,91 @@ copy_enum_args(char *args)
 static void
 free_enum_args(char *args)
 {
-	if (args != NULL)
-		free(args);
+	enum_args *ea;
+
+	if (args != NULL) {
+		ea = (enum_args *) (void *) args;
+		ea->references--;
+		if (ea->references == 0) {
+			free_enum_keys(ea);
+			free(args);
+		}
+	}
 }
 
 /*
  * Attempt to match the string in this to the choices given.  Returns
- * TRUE if match found otherwise FALSE.
- * 
+ * TRUE if match found otherwise FALSE.  The match returned is the first
+ * choice, in the order given, that either equals the trimmed string or,
+ * if an exact match is not required, starts with it.
  */
 static bool
-match_enum(char **choices, unsigned num_choices, bool ignore_case,
-	   bool exact, char *this, unsigned *match_num)
+match_enum(enum_args *ea, char *this, unsigned *match_num)
 {
-	unsigned i, start, end, enum_start, blen, elen, enum_end;
-	bool cur_match;
+	unsigned start, blen, lo, hi, mid, best;
 
-	start = _formi_skip_blanks(this, 0);
-	end = trim_blanks(this);
+	if (ea->num_choices == 0)
+		return FALSE;
 
-	if (end >= start)
-		blen = (unsigned) (strlen(&this[start])
-				   - strlen(&this[end]) + 1);
-	else
-		blen = 0;
+	blen = trimmed_key(this, &start);
+	this = &this[start];
 
 	_formi_dbg_printf("%s: start %u, blen %u\n", __func__, start, blen);
-	for (i = 0; i < num_choices; i++) {
-		enum_start = _formi_skip_blanks(choices[i], 0);
-		enum_end = trim_blanks(choices[i]);
 
-		if (enum_end >= enum_start)
-			elen = (unsigned) (strlen(&choices[i][enum_start])
-				- strlen(&choices[i][enum_end]) + 1);
+	  /* the keys this is a prefix of are those from lo up to hi */
+	lo = 0;
+	hi = ea->num_choices;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (compare_prefix(&ea->keys[mid], this, blen,
+				   ea->ignore_case) < 0)
+			lo = mid + 1;
 		else
-			elen = 0;
-		
-		_formi_dbg_printf("%s: checking choice \'%s\'\n", __func__,
-			choices[i]);
-		_formi_dbg_printf("%s: enum_start %u, elen %u\n", __func__,
-			enum_start, elen);
-		
-		  /* don't bother if we are after an exact match
-		   * and the test length is not equal to the enum
-		   * in question - it will never match.
-		   */
-		if ((exact == TRUE) && (blen != elen))
-			continue;
-
-		  /*
-		   * If the test length is longer than the enum
-		   * length then there is no chance of a match
-		   * so we skip.
-		   */
-		if ((exact != TRUE) && (blen > elen))
-			continue;
-		
-		if (ignore_case)
-			cur_match = (strncasecmp(&choices[i][enum_start],
-						 &this[start],
-						 (size_t)blen) == 0) ?
-				TRUE : FALSE;
+			hi = mid;
+	}
+
+	hi = ea->num_choices;
+	mid = lo;
+	while (mid < hi) {
+		best = mid + (hi - mid) / 2;
+		if (compare_prefix(&ea->keys[best], this, blen,
+				   ea->ignore_case) > 0)
+			hi = best;
 		else
-			cur_match = (strncmp(&choices[i][enum_start],
-					     &this[start],
-					     (size_t) blen) == 0) ?
-				TRUE : FALSE;
-
-		_formi_dbg_printf("%s: curmatch is %s\n", __func__,
-			(cur_match == TRUE)? "TRUE" : "FALSE");
-		
-		if (cur_match == TRUE) {
-			*match_num = i;
-			return TRUE;
+			mid = best + 1;
+	}
+
+	if (lo == hi) {
+		_formi_dbg_printf("%s: no match found\n", __func__);
+		return FALSE;
+	}
+
+	if (ea->exact == TRUE) {
+		  /* the shortest key sorts first, lowest index among equals */
+		if (ea->keys[lo].len != blen) {
+			_formi_dbg_printf("%s: no match found\n", __func__);
+			return FALSE;
 		}
+		*match_num = ea->keys[lo].index;
+		return TRUE;
+	}
 
+	  /* the lowest choice index in the run of keys */
+	best = ea->num_choices;
+	for (lo += ea->num_choices, hi += ea->num_choices; lo < hi;
+	     lo /= 2, hi /= 2) {
+		if (lo & 1) {
+			best = MIN(best, ea->min_index[lo]);
+			lo++;
+		}
+		if (hi & 1) {
+			hi--;
+			best = MIN(best, ea->min_index[hi]);
+		}
 	}
 
-	_formi_dbg_printf("%s: no match found\n", __func__);
-	return FALSE;
+	*match_num = best;
+	return TRUE;
 }
 
 /*
@@ -228,8 +387,7 @@ enum_check_field(FIELD *field, char *args)
 	
 	ta = (enum_args *) (void *) field->args;
 	
-	if (match_enum(ta->choices, ta->num_choices, ta->ignore_case,
-		       ta->exact, args, &match_num) == TRUE) {
+	if (match_enum(ta, args, &match_num) == TRUE) {
 		_formi_dbg_printf("%s: We matched, match_num %u\n", __func__,
 		    match_num);
 		_formi_dbg_printf("%s: buffer is \'%s\'\n", __func__,
@@ -257,8 +415,7 @@ next_enum(FIELD *field, char *args)
 
 	_formi_dbg_printf("%s: attempt to match \'%s\'\n", __func__, args);
 
-	if (match_enum(ta->choices, ta->num_choices, ta->ignore_case,
-		       ta->exact, args, &cur_choice) == FALSE) {
+	if (match_enum(ta, args, &cur_choice) == FALSE) {
 		_formi_dbg_printf("%s: match failed\n", __func__);
 		return FALSE;
 	}
@@ -293,8 +450,7 @@ prev_enum(FIELD *field, char *args)
 	
 	_formi_dbg_printf("%s: attempt to match \'%s\'\n", __func__, args);
 
-	if (match_enum(ta->choices, ta->num_choices, ta->ignore_case,
-		       ta->exact, args, &cur_choice) == FALSE) {
+	if (match_enum(ta, args, &cur_choice) == FALSE) {
 		_formi_dbg_printf("%s: match failed\n", __func__);
 		return FALSE;
 	}
@@ -94,54 +94,110 @@ free_integer_args(char *args)
 }
 
 /*
- * Check the contents of the field buffer are digits only.
+ * How far the scan of an integer field has got.  The field may hold
+ * blanks, an optional sign and digits, then trailing blanks only.
+ */
+#define INTEGER_LEAD	0	/* only blanks seen so far */
+#define INTEGER_DIGITS	1	/* in the sign and digits */
+#define INTEGER_TRAIL	2	/* in the trailing blanks */
+#define INTEGER_BAD	3	/* the field cannot be an integer */
+
+typedef struct
+{
+	int state;
+	int negative;			/* the number has a minus sign */
+	unsigned long magnitude;	/* value of the digits, saturated */
+} integer_stream;
+
+/*
+ * Start the scan of an integer field.
+ */
+static void
+integer_init(integer_stream *is)
+{
+	is->state = INTEGER_LEAD;
+	is->negative = FALSE;
+	is->magnitude = 0;
+}
+
+/*
+ * Advance the scan of an integer field by the character c, keeping the
+ * value of the number as it goes so the field need not be converted
+ * again when the scan is done.
+ */
+static void
+integer_scan(integer_stream *is, int c)
+{
+	unsigned long digit;
+
+	switch (is->state) {
+	case INTEGER_LEAD:
+		if ((c == ' ') || (c == '\t'))
+			return;
+		if ((c == '-') || (c == '+')) {
+			is->negative = (c == '-');
+			is->state = INTEGER_DIGITS;
+			return;
+		}
+		if (!isdigit(c))
+			break;
+		is->state = INTEGER_DIGITS;
+		/* FALLTHROUGH */
+	case INTEGER_DIGITS:
+		if (isdigit(c)) {
+			digit = c - '0';
+			if (is->magnitude > (ULONG_MAX - digit) / 10)
+				is->magnitude = ULONG_MAX;
+			else
+				is->magnitude = is->magnitude * 10 + digit;
+			return;
+		}
+		/* FALLTHROUGH */
+	case INTEGER_TRAIL:
+		if ((c == ' ') || (c == '\t')) {
+			is->state = INTEGER_TRAIL;
+			return;
+		}
+		break;
+
+	default:
+		return;
+	}
+
+	is->state = INTEGER_BAD;
+}
+
+/*
+ * Range check the scanned number and reformat it to the precision
+ * required.  A number too big for a long is clamped as strtol(3) does.
+ * The field buffer in buf is only set when the reformat changes it, so
+ * the field keeps the state of the scan for the next append.
  */
 static int
-integer_check_field(FIELD *field, char *args)
+integer_finish(FIELD *field, integer_stream *is, char *buf)
 {
-	int cur, ret;
+	int ret;
 	long number, max, min;
 	int precision;
-	char *buf, *new_buf;
+	char *new_buf;
 	size_t len;
 
-	if (args == NULL)
+	  /* no good if there is nothing but blanks or junk */
+	if ((is->state != INTEGER_DIGITS) && (is->state != INTEGER_TRAIL))
 		return FALSE;
-	
+
 	precision = ((integer_args *) (void *) field->args)->precision;
 	min = ((integer_args *) (void *) field->args)->min;
 	max = ((integer_args *) (void *) field->args)->max;
 	
-	buf = args;
-	cur = 0;
-
-	  /* skip leading white space */
-	while ((buf[cur] != '\0')
-	       && ((buf[cur] == ' ') || (buf[cur] == '\t')))
-		cur++;
-
-	  /* no good if we have hit the end */
-	if (buf[cur] == '\0')
-		return FALSE;
-
-	  /* find the end of the digits but allow a leading + or - sign */
-	if ((buf[cur] == '-') || (buf[cur] == '+'))
-		cur++;
-	
-	while(isdigit((unsigned char)buf[cur]))
-		cur++;
-
-	  /* check there is only trailing whitespace */
-	while ((buf[cur] != '\0')
-	       && ((buf[cur] == ' ') || (buf[cur] == '\t')))
-		cur++;
-
-	  /* no good if we are not at the end of the string */
-	if (buf[cur] != '\0')
-		return FALSE;
-
 	  /* convert and range check the number...*/
-	number = atol(buf);
+	if (!is->negative)
+		number = (is->magnitude > LONG_MAX) ? LONG_MAX
+		    : (long) is->magnitude;
+	else if (is->magnitude > (unsigned long) LONG_MAX)
+		number = LONG_MIN;
+	else
+		number = -(long) is->magnitude;
 	if ((min > max) || ((number < min) || (number > max)))
 		return FALSE;
 
@@ -155,7 +211,8 @@ integer_check_field(FIELD *field, char *args)
 		return FALSE;
 
 	  /* re-set the field buffer to be the reformatted numeric */
-	set_field_buffer(field, 0, new_buf);
+	if (strcmp(new_buf, buf) != 0)
+		set_field_buffer(field, 0, new_buf);
 
 	free(new_buf);
 	
@@ -163,6 +220,62 @@ integer_check_field(FIELD *field, char *args)
 	return TRUE;
 }
 
+/*
+ * Check the contents of the field buffer are digits only.
+ */
+static int
+integer_check_field(FIELD *field, char *args)
+{
+	integer_stream is;
+	char *buf;
+
+	if (args == NULL)
+		return FALSE;
+	
+	integer_init(&is);
+	for (buf = args; *buf != '\0'; buf++)
+		integer_scan(&is, (unsigned char) *buf);
+
+	return integer_finish(field, &is, args);
+}
+
+/*
+ * Start the incremental scan of an integer field.
+ */
+static char *
+integer_stream_new(char *args)
+{
+	integer_stream *new;
+
+	if ((new = malloc(sizeof(*new))) != NULL)
+		integer_init(new);
+
+	return (void *) new;
+}
+
+/*
+ * Add a character appended to the field to the scan.
+ */
+static void
+integer_stream_char(char *stream, int c, char *args)
+{
+	integer_scan((integer_stream *) (void *) stream, c);
+}
+
+/*
+ * Check an integer field the scan has already covered, the scan holds
+ * the number so the field buffer is only compared with the reformat.
+ */
+static int
+integer_stream_check(FIELD *field, char *stream, char *args)
+{
+	if (args == NULL)
+		return FALSE;
+
+	return integer_finish(field, (integer_stream *) (void *) stream,
+	    args);
+}
+
 /*
  * Check the given character is numeric, return TRUE if it is.
  */
@@ -182,7 +295,10 @@ static FIELDTYPE builtin_integer = {
 	integer_check_field,                  /* field_check */
 	integer_check_char,                   /* char_check */
 	NULL,                               /* next_choice */
-	NULL                                /* prev_choice */
+	NULL,                               /* prev_choice */
+	integer_stream_new,                 /* stream_new */
+	integer_stream_char,                /* stream_char */
+	integer_stream_check                /* stream_check */
 };
 
 FIELDTYPE *TYPE_INTEGER = &builtin_integer;
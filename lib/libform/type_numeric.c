@@ -93,86 +93,189 @@ free_numeric_args(char *args)
 }
 
 /*
- * Check the contents of the field buffer are numeric only.  A valid
- * number is of the form nnnn[.mmmmm][Ee[+-]ddd]
+ * How far the scan of a numeric field has got.  The field may hold
+ * blanks, a number of the form [+-]nnnn[.mmmmm][Ee[+-]ddd] and then
+ * trailing blanks only.
+ */
+#define NUMERIC_LEAD	0	/* only blanks seen so far */
+#define NUMERIC_INT	1	/* in the sign and integer digits */
+#define NUMERIC_FRAC	2	/* in the fraction digits */
+#define NUMERIC_EXP	3	/* just seen the exponent marker */
+#define NUMERIC_ESIGN	4	/* just seen the exponent sign */
+#define NUMERIC_EDIGITS	5	/* in the exponent digits */
+#define NUMERIC_TRAIL	6	/* in the trailing blanks */
+#define NUMERIC_BAD	7	/* the field cannot be a number */
+
+/*
+ * The scan keeps the digits of the mantissa while they fit in a double
+ * exactly, up to 15 significant digits, along with where the decimal
+ * point goes.  Scaling that by an exact power of ten is one correctly
+ * rounded operation so gives the same number strtod(3) would.
+ */
+#define NUMERIC_EXACT_DIGITS	15
+#define NUMERIC_EXACT_POW10	22
+#define NUMERIC_EXP_MAX		100000	/* saturate the exponent here */
+
+typedef struct
+{
+	int state;
+	int negative;		/* the mantissa has a minus sign */
+	int exp_negative;	/* the exponent has a minus sign */
+	unsigned digits;	/* mantissa digits seen */
+	unsigned sig_digits;	/* mantissa digits from the first non-zero */
+	unsigned frac_digits;	/* mantissa digits after the point */
+	unsigned exponent;	/* value of the exponent digits */
+	double mantissa;	/* value of the significant digits */
+} numeric_stream;
+
+static const double numeric_pow10[NUMERIC_EXACT_POW10 + 1] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * Advance the scan of a numeric field by the character c.
  */
 static int
-numeric_check_field(FIELD *field, char *args)
+numeric_scan(int state, int c)
 {
-	int cur, ret;
-	double number, max, min;
-	int precision;
-	char *buf, *new_buf;
+	switch (state) {
+	case NUMERIC_LEAD:
+		if ((c == ' ') || (c == '\t'))
+			return NUMERIC_LEAD;
+		if ((c == '-') || (c == '+'))
+			return NUMERIC_INT;
+		/* FALLTHROUGH */
+	case NUMERIC_INT:
+		if (isdigit(c))
+			return NUMERIC_INT;
+		if (c == '.')
+			return NUMERIC_FRAC;
+		break;
 
-	if (args == NULL)
-		return FALSE;
-	
-	precision = ((numeric_args *) (void *) field->args)->precision;
-	min = ((numeric_args *) (void *) field->args)->min;
-	max = ((numeric_args *) (void *) field->args)->max;
-	
-	buf = args;
-	cur = 0;
+	case NUMERIC_FRAC:
+		if (isdigit(c))
+			return NUMERIC_FRAC;
+		break;
 
-	  /* skip leading white space */
-	while ((buf[cur] != '\0')
-	       && ((buf[cur] == ' ') || (buf[cur] == '\t')))
-		cur++;
+	case NUMERIC_EXP:
+		if ((c == '+') || (c == '-'))
+			return NUMERIC_ESIGN;
+		/* FALLTHROUGH */
+	case NUMERIC_ESIGN:
+		return (isdigit(c)) ? NUMERIC_EDIGITS : NUMERIC_BAD;
 
-	  /* no good if we have hit the end */
-	if (buf[cur] == '\0')
-		return FALSE;
+	case NUMERIC_EDIGITS:
+		if (isdigit(c))
+			return NUMERIC_EDIGITS;
+		/* FALLTHROUGH */
+	case NUMERIC_TRAIL:
+		if ((c == ' ') || (c == '\t'))
+			return NUMERIC_TRAIL;
+		return NUMERIC_BAD;
 
-	  /* find the end of the digits but allow a leading + or - sign, and
-	   * a decimal point.
-	   */
-	if ((buf[cur] == '-') || (buf[cur] == '+'))
-		cur++;
-	
-	while(isdigit((unsigned char)buf[cur]))
-		cur++;
-
-	  /* if not at end of string then check for decimal... */
-	if (buf[cur] == '.') {
-		cur++;
-		/* check for more digits now.... */
-		while (buf[cur] && isdigit((unsigned char)buf[cur]))
-			cur++;
+	default:
+		return NUMERIC_BAD;
 	}
-	
-	  /* check for an exponent */
-	if ((buf[cur] == 'E') || (buf[cur] == 'e')) {
-		cur++;
-		if (buf[cur] == '\0')
-			return FALSE;
-			
-		  /* allow a + or a - for exponent */
-		if ((buf[cur] == '+') || (buf[cur] == '-'))
-			cur++;
-
-		if (buf[cur] == '\0')
-			return FALSE;
-			
-		  /* we expect a digit now */
-		if (!isdigit((unsigned char)buf[cur]))
-			return FALSE;
-			
-		  /* skip digits for the final time */
-		while(isdigit((unsigned char)buf[cur]))
-			cur++;
+
+	  /* the mantissa may be followed by an exponent or blanks */
+	if ((c == 'E') || (c == 'e'))
+		return NUMERIC_EXP;
+	if ((c == ' ') || (c == '\t'))
+		return NUMERIC_TRAIL;
+
+	return NUMERIC_BAD;
+}
+
+/*
+ * Start the scan of a numeric field.
+ */
+static void
+numeric_init(numeric_stream *ns)
+{
+	memset(ns, 0, sizeof(*ns));
+	ns->state = NUMERIC_LEAD;
+}
+
+/*
+ * Add the character c to the scan of a numeric field and keep the parts
+ * of the number up to date.
+ */
+static void
+numeric_add(numeric_stream *ns, int c)
+{
+	ns->state = numeric_scan(ns->state, c);
+
+	switch (ns->state) {
+	case NUMERIC_INT:
+	case NUMERIC_FRAC:
+		if (c == '-')
+			ns->negative = TRUE;
+		if (!isdigit(c))
+			break;
+		ns->digits++;
+		if (ns->state == NUMERIC_FRAC)
+			ns->frac_digits++;
+		if ((ns->sig_digits == 0) && (c == '0'))
+			break;
+		if (++ns->sig_digits <= NUMERIC_EXACT_DIGITS)
+			ns->mantissa = ns->mantissa * 10 + (c - '0');
+		break;
+
+	case NUMERIC_ESIGN:
+		ns->exp_negative = (c == '-');
+		break;
+
+	case NUMERIC_EDIGITS:
+		if (ns->exponent < NUMERIC_EXP_MAX)
+			ns->exponent = ns->exponent * 10 + (c - '0');
+		break;
 	}
-			
-	  /* check there is only trailing whitespace */
-	while ((buf[cur] != '\0')
-	       && ((buf[cur] == ' ') || (buf[cur] == '\t')))
-		cur++;
-
-	  /* no good if we are not at the end of the string */
-	if (buf[cur] != '\0')
+}
+
+/*
+ * Range check the scanned number and reformat it to the precision
+ * required.  The number only has to be converted from the field buffer
+ * in buf when it has too many digits or too big an exponent to be built
+ * exactly from the scan.  buf is only set when the reformat changes it,
+ * so the field keeps the state of the scan for the next append.
+ */
+static int
+numeric_finish(FIELD *field, numeric_stream *ns, char *buf)
+{
+	int ret;
+	double number, max, min;
+	long scale;
+	int precision;
+	char *new_buf;
+
+	  /* no good if there is nothing but blanks, junk or half a number */
+	if ((ns->state == NUMERIC_LEAD) || (ns->state == NUMERIC_EXP)
+	    || (ns->state == NUMERIC_ESIGN) || (ns->state == NUMERIC_BAD))
 		return FALSE;
 
+	precision = ((numeric_args *) (void *) field->args)->precision;
+	min = ((numeric_args *) (void *) field->args)->min;
+	max = ((numeric_args *) (void *) field->args)->max;
+	
 	  /* convert and range check the number...*/
-	number = atof(buf);
+	scale = (long) ns->exponent;
+	if (ns->exp_negative)
+		scale = -scale;
+	scale -= (long) ns->frac_digits;
+	if (ns->digits == 0)
+		number = 0.0;	/* a lone sign or point converts to zero */
+	else if ((ns->sig_digits <= NUMERIC_EXACT_DIGITS)
+		 && (scale >= -NUMERIC_EXACT_POW10)
+		 && (scale <= NUMERIC_EXACT_POW10)) {
+		if (scale < 0)
+			number = ns->mantissa / numeric_pow10[-scale];
+		else
+			number = ns->mantissa * numeric_pow10[scale];
+		if (ns->negative)
+			number = -number;
+	} else
+		number = atof(buf);
 	if ((min < max) && ((number < min) || (number > max)))
 		return FALSE;
 
@@ -185,7 +288,8 @@ numeric_check_field(FIELD *field, char *args)
 	}
 
 	  /* re-set the field buffer to be the reformatted numeric */
-	set_field_buffer(field, 0, new_buf);
+	if (strcmp(new_buf, buf) != 0)
+		set_field_buffer(field, 0, new_buf);
 
 	free(new_buf);
 	
@@ -193,6 +297,63 @@ numeric_check_field(FIELD *field, char *args)
 	return TRUE;
 }
 
+/*
+ * Check the contents of the field buffer are numeric only.  A valid
+ * number is of the form nnnn[.mmmmm][Ee[+-]ddd]
+ */
+static int
+numeric_check_field(FIELD *field, char *args)
+{
+	numeric_stream ns;
+	char *buf;
+
+	if (args == NULL)
+		return FALSE;
+	
+	numeric_init(&ns);
+	for (buf = args; *buf != '\0'; buf++)
+		numeric_add(&ns, (unsigned char) *buf);
+
+	return numeric_finish(field, &ns, args);
+}
+
+/*
+ * Start the incremental scan of a numeric field.
+ */
+static char *
+numeric_stream_new(char *args)
+{
+	numeric_stream *new;
+
+	if ((new = malloc(sizeof(*new))) != NULL)
+		numeric_init(new);
+
+	return (void *) new;
+}
+
+/*
+ * Add a character appended to the field to the scan.
+ */
+static void
+numeric_stream_char(char *stream, int c, char *args)
+{
+	numeric_add((numeric_stream *) (void *) stream, c);
+}
+
+/*
+ * Check a numeric field the scan has already covered.  The field buffer
+ * is only looked at again for a number the scan could not build.
+ */
+static int
+numeric_stream_check(FIELD *field, char *stream, char *args)
+{
+	if (args == NULL)
+		return FALSE;
+
+	return numeric_finish(field, (numeric_stream *) (void *) stream,
+	    args);
+}
+
 /*
  * Check the given character is numeric, return TRUE if it is.
  */
@@ -213,7 +374,10 @@ static FIELDTYPE builtin_numeric = {
 	numeric_check_field,                  /* field_check */
 	numeric_check_char,                   /* char_check */
 	NULL,                               /* next_choice */
-	NULL                                /* prev_choice */
+	NULL,                               /* prev_choice */
+	numeric_stream_new,                 /* stream_new */
+	numeric_stream_char,                /* stream_char */
+	numeric_stream_check                /* stream_check */
 };
 
 FIELDTYPE *TYPE_NUMERIC = &builtin_numeric;
@@ -108,6 +108,55 @@ regex_check_field(FIELD *field, char *args)
 	return FALSE;
 }
 
+/*
+ * The regex library cannot resume a match where it left off, so the
+ * incremental state just remembers the verdict for the field contents
+ * it was last computed for.  Any appended character forgets it.
+ */
+#define REGEX_UNKNOWN	-1
+
+typedef struct
+{
+	int verdict;
+} regex_stream;
+
+/*
+ * Start the incremental state of a regex field.
+ */
+static char *
+regex_stream_new(char *args)
+{
+	regex_stream *new;
+
+	if ((new = malloc(sizeof(*new))) != NULL)
+		new->verdict = REGEX_UNKNOWN;
+
+	return (void *) new;
+}
+
+/*
+ * A character was appended to the field, the old verdict no longer holds.
+ */
+static void
+regex_stream_char(char *stream, int c, char *args)
+{
+	((regex_stream *) (void *) stream)->verdict = REGEX_UNKNOWN;
+}
+
+/*
+ * Check the field against the regex unless the verdict is already known.
+ */
+static int
+regex_stream_check(FIELD *field, char *stream, char *args)
+{
+	regex_stream *rs = (regex_stream *) (void *) stream;
+
+	if (rs->verdict == REGEX_UNKNOWN)
+		rs->verdict = regex_check_field(field, args);
+
+	return rs->verdict;
+}
+
 static FIELDTYPE builtin_regex = {
 	_TYPE_HAS_ARGS | _TYPE_IS_BUILTIN,  /* flags */
 	0,                                  /* refcount */
@@ -118,7 +167,10 @@ static FIELDTYPE builtin_regex = {
 	regex_check_field,                  /* field_check */
 	NULL,                               /* char_check */
 	NULL,                               /* next_choice */
-	NULL                                /* prev_choice */
+	NULL,                               /* prev_choice */
+	regex_stream_new,                   /* stream_new */
+	regex_stream_char,                  /* stream_char */
+	regex_stream_check                  /* stream_check */
 };
 
 FIELDTYPE *TYPE_REGEXP = &builtin_regex;
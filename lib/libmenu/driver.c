@@ -80,6 +80,7 @@ menu_driver(MENU *menu, int c)
 			menu->pattern = NULL;
 			menu->plen = 0;
 			menu->match_len = 0;
+			_menui_reset_match(menu);
 		}
 		
 		switch (c) {
@@ -180,17 +181,18 @@ menu_driver(MENU *menu, int c)
 					  return E_REQUEST_DENIED;
 				  
 				  /* deselect all items */
-			          for (i = 0; i < menu->item_count; i++) {
-				      if ((menu->items[i]->selected) &&
-					  (drv_new_item->index != i)) {
-				          menu->items[i]->selected ^= 1;
-					  _menui_draw_item(menu,
-						menu->items[i]->index);
+			          for (i = _menui_next_selected(menu, -1);
+				       i >= 0;
+				       i = _menui_next_selected(menu, i)) {
+				      if (drv_new_item->index != i) {
+				          _menui_select_item(menu,
+						menu->items[i], 0);
+					  _menui_draw_item(menu, i);
 				      }
 				  }
 
 				    /* turn on selected item */
-				  drv_new_item->selected ^= 1;
+				  _menui_select_item(menu, drv_new_item, 1);
 				  _menui_draw_item(menu, drv_new_item->index);
 			      } else {
 			      	  return E_REQUEST_DENIED;
@@ -199,7 +201,8 @@ menu_driver(MENU *menu, int c)
 				  if ((drv_new_item->opts
 				       & O_SELECTABLE) == O_SELECTABLE) {
 					    /* toggle select flag */
-					  drv_new_item->selected ^= 1;
+					  _menui_select_item(menu, drv_new_item,
+						drv_new_item->selected ^ 1);
 					    /* update item in menu */
 					  _menui_draw_item(menu,
 						drv_new_item->index);
@@ -218,7 +221,8 @@ menu_driver(MENU *menu, int c)
 			  
 			  if (menu->plen == 0)
 				  return E_REQUEST_DENIED;
-			  menu->pattern[menu->plen--] = '\0';
+			  menu->pattern[--menu->plen] = '\0';
+			  _menui_reset_match(menu);
 			  break;
 		  case REQ_NEXT_MATCH:
 			  if (menu->pattern == NULL)
@@ -28,6 +28,7 @@
 
 #include <menu.h>
 #include <ctype.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
@@ -37,6 +38,8 @@
 static void
 _menui_calc_neighbours(MENU *menu, int item_no);
 static void _menui_redraw_menu(MENU *menu, int old_top_row, int old_cur_item);
+static void _menui_draw_row(MENU *menu, int row);
+static void _menui_scroll_menu(MENU *menu, int lines, int height);
 
   /*
    * Link all the menu items together to speed up navigation.  We need
@@ -270,6 +273,86 @@ _menui_calc_neighbours(MENU *menu, int item_no)
 	}
 }
 
+/*
+ * Number of items covered by each word of the selection bitmap.
+ */
+#define SEL_BITS	((int) (sizeof(unsigned int) * CHAR_BIT))
+
+/*
+ * Allocate a selection bitmap for the count items given with the bits
+ * set for the items that are already selected.  The number of selected
+ * items is returned in sel_count.  Return NULL if the allocation fails.
+ */
+unsigned int *
+_menui_new_selection(ITEM **items, int count, int *sel_count)
+{
+	unsigned int *sel_map;
+	int i;
+
+	if ((sel_map = calloc((size_t) (count / SEL_BITS + 1),
+			      sizeof(*sel_map))) == NULL)
+		return NULL;
+
+	*sel_count = 0;
+	for (i = 0; i < count; i++) {
+		if (items[i]->selected) {
+			sel_map[i / SEL_BITS] |= 1U << (i % SEL_BITS);
+			(*sel_count)++;
+		}
+	}
+
+	return sel_map;
+}
+
+/*
+ * Set the selected flag of an item connected to the menu, keeping the
+ * selection bitmap and count in step.
+ */
+void
+_menui_select_item(MENU *menu, ITEM *item, int flag)
+{
+	unsigned int *word, bit;
+
+	word = &menu->sel_map[item->index / SEL_BITS];
+	bit = 1U << (item->index % SEL_BITS);
+
+	if (flag && ((*word & bit) == 0)) {
+		*word |= bit;
+		menu->sel_count++;
+	} else if (!flag && ((*word & bit) != 0)) {
+		*word &= ~bit;
+		menu->sel_count--;
+	}
+
+	item->selected = flag;
+}
+
+/*
+ * Return the index of the first selected item after the item given or -1
+ * if there are no more selected items.  Passing -1 returns the first
+ * selected item.
+ */
+int
+_menui_next_selected(MENU *menu, int item)
+{
+	unsigned int bits;
+	int word, nwords;
+
+	if ((menu->sel_count == 0) || (++item >= menu->item_count))
+		return -1;
+
+	word = item / SEL_BITS;
+	nwords = menu->item_count / SEL_BITS + 1;
+	bits = menu->sel_map[word] & (~0U << (item % SEL_BITS));
+	while (bits == 0) {
+		if (++word >= nwords)
+			return -1;
+		bits = menu->sel_map[word];
+	}
+
+	return word * SEL_BITS + ffs((int) bits) - 1;
+}
+
 /*
  * Goto the item pointed to by item and adjust the menu structure
  * accordingly.  Call the term and init functions if required.
@@ -316,57 +399,258 @@ _menui_goto_item(MENU *menu, ITEM *item, int new_top_row)
 }
 
 /*
- * Attempt to match items with the pattern buffer in the direction given
- * by iterating over the menu items.  If a match is found return E_OK
- * otherwise return E_NO_MATCH
+ * Return the character c of a key folded as the index requires.
  */
-int
-_menui_match_items(MENU *menu, int direction, int *item_matched)
+#define KEY_CHAR(c, caseless) \
+	((caseless) ? tolower((unsigned char) (c)) : (unsigned char) (c))
+
+/*
+ * Compare two keys of the match index character by character, a key
+ * that is a prefix of the other sorts first and equal keys sort in item
+ * order.
+ */
+static int
+_menui_key_compare(const struct _menui_key *a, const struct _menui_key *b,
+		   int caseless)
 {
-	int i, caseless;
+	int i, len, ca, cb;
+
+	len = min(a->len, b->len);
+	for (i = 0; i < len; i++) {
+		ca = KEY_CHAR(a->key[i], caseless);
+		cb = KEY_CHAR(b->key[i], caseless);
+		if (ca != cb)
+			return ca - cb;
+	}
+
+	if (a->len != b->len)
+		return a->len - b->len;
+
+	return a->item - b->item;
+}
+
+static int
+_menui_key_cmp(const void *one, const void *two)
+{
+	return _menui_key_compare(one, two, 0);
+}
+
+static int
+_menui_key_casecmp(const void *one, const void *two)
+{
+	return _menui_key_compare(one, two, 1);
+}
+
+/*
+ * Free the match index of the menu, it will be rebuilt when next needed.
+ */
+void
+_menui_free_match(MENU *menu)
+{
+	if (menu->match == NULL)
+		return;
+
+	free(menu->match->keys);
+	free(menu->match);
+	menu->match = NULL;
+}
+
+/*
+ * Forget the range of keys matched so far, the next match will start
+ * again from the first character of the pattern.  This must be called
+ * whenever the pattern is cut back or replaced.
+ */
+void
+_menui_reset_match(MENU *menu)
+{
+	if (menu->match == NULL)
+		return;
+
+	menu->match->depth = 0;
+	menu->match->lo = 0;
+	menu->match->hi = menu->match->count;
+}
+
+/*
+ * Build the match index for the menu items if there is not one already
+ * built for the current menu options.  The keys are the item names or,
+ * if O_SUBSTRING is set, every suffix of each item name.  Sorting the keys
+ * puts all the keys starting with the pattern into a single range.
+ */
+static int
+_menui_build_match(MENU *menu)
+{
+	struct _menui_match *match;
+	ITEM *item;
+	int caseless, substring, count, i, j, len;
 
 	caseless = ((menu->opts & O_IGNORECASE) == O_IGNORECASE);
+	substring = ((menu->opts & O_SUBSTRING) == O_SUBSTRING);
 
-	i = menu->cur_item;
-	if (direction == MATCH_NEXT_FORWARD) {
-		if (++i >= menu->item_count) i = 0;
-	} else if (direction == MATCH_NEXT_REVERSE) {
-		if (--i < 0) i = menu->item_count - 1;
+	if (menu->match != NULL) {
+		if ((menu->match->caseless == caseless)
+		    && (menu->match->substring == substring))
+			return E_OK;
+		_menui_free_match(menu);
 	}
 
+	count = 0;
+	for (i = 0; i < menu->item_count; i++) {
+		if (substring)
+			count += max(menu->items[i]->name.length, 1);
+		else
+			count++;
+	}
 
-	do {
-		if (menu->items[i]->name.length >= menu->plen) {
-			  /* no chance if pattern is longer */
-			if (caseless) {
-				if (strncasecmp(menu->items[i]->name.string,
-						menu->pattern,
-						(size_t) menu->plen) == 0) {
-					*item_matched = i;
-					menu->match_len = menu->plen;
-					return E_OK;
-				}
-			} else {
-				if (strncmp(menu->items[i]->name.string,
-					    menu->pattern,
-					    (size_t) menu->plen) == 0) {
-					*item_matched = i;
-					menu->match_len = menu->plen;
-					return E_OK;
-				}
-			}
+	if ((match = malloc(sizeof(*match))) == NULL)
+		return E_SYSTEM_ERROR;
+
+	if ((match->keys = malloc(count * sizeof(*match->keys))) == NULL) {
+		free(match);
+		return E_SYSTEM_ERROR;
+	}
+
+	count = 0;
+	for (i = 0; i < menu->item_count; i++) {
+		item = menu->items[i];
+		len = (substring) ? max(item->name.length, 1) : 1;
+		for (j = 0; j < len; j++) {
+			match->keys[count].key = item->name.string + j;
+			match->keys[count].len = max(item->name.length - j, 0);
+			match->keys[count].item = i;
+			match->keys[count].offset = j;
+			count++;
 		}
+	}
 
-		if ((direction == MATCH_FORWARD) ||
-		    (direction == MATCH_NEXT_FORWARD)) {
-			if (++i >= menu->item_count) i = 0;
-		} else {
-			if (--i <= 0) i = menu->item_count - 1;
+	qsort(match->keys, (size_t) count, sizeof(*match->keys),
+	      (caseless) ? _menui_key_casecmp : _menui_key_cmp);
+
+	match->caseless = caseless;
+	match->substring = substring;
+	match->count = count;
+	match->offset = 0;
+	menu->match = match;
+	_menui_reset_match(menu);
+
+	return E_OK;
+}
+
+/*
+ * Narrow the range of keys matching the pattern so far to those that
+ * also have the character c next.  Return the number of keys left, the
+ * range is only updated if there are some.
+ */
+static int
+_menui_narrow_match(struct _menui_match *match, int c)
+{
+	int lo, hi, mid, first, depth, caseless;
+	struct _menui_key *key;
+
+	depth = match->depth;
+	caseless = match->caseless;
+	c = KEY_CHAR(c, caseless);
+
+	  /* find the first key with c or greater at the depth */
+	lo = match->lo;
+	hi = match->hi;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		key = &match->keys[mid];
+		if ((key->len > depth) && (KEY_CHAR(key->key[depth], caseless)
+					   >= c))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	first = lo;
+
+	  /* and then the first key past c */
+	hi = match->hi;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		key = &match->keys[mid];
+		if (KEY_CHAR(key->key[depth], caseless) > c)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	if (lo > first) {
+		match->lo = first;
+		match->hi = lo;
+		match->depth++;
+	}
+
+	return lo - first;
+}
+
+/*
+ * Attempt to match items with the pattern buffer in the direction given.
+ * The range of keys in the match index that start with the pattern is
+ * narrowed for each character added to the pattern since the last match,
+ * then the matching item nearest the current item in the direction of the
+ * match is chosen.  If a match is found return E_OK otherwise return
+ * E_NO_MATCH
+ */
+int
+_menui_match_items(MENU *menu, int direction, int *item_matched)
+{
+	struct _menui_match *match;
+	int i, item, forward, next, dist, offset, best, best_dist, best_offset;
+	int status;
+
+	if ((status = _menui_build_match(menu)) != E_OK)
+		return status;
+	match = menu->match;
+
+	while (match->depth < menu->plen) {
+		if (_menui_narrow_match(match,
+					menu->pattern[match->depth]) == 0) {
+			menu->match_len = 0; /* match did not succeed */
+			return E_NO_MATCH;
+		}
+	}
+
+	forward = ((direction == MATCH_FORWARD)
+		   || (direction == MATCH_NEXT_FORWARD));
+	next = ((direction == MATCH_NEXT_FORWARD)
+		|| (direction == MATCH_NEXT_REVERSE));
+
+	best = -1;
+	best_dist = 0;
+	best_offset = 0;
+	for (i = match->lo; i < match->hi; i++) {
+		item = match->keys[i].item;
+		if (forward)
+			dist = item - menu->cur_item;
+		else
+			dist = menu->cur_item - item;
+		if (dist < 0)
+			dist += menu->item_count;
+
+		  /* a next match moves off the current item if it can */
+		if (next && (dist == 0) && (menu->item_count > 1))
+			continue;
+
+		offset = match->keys[i].offset;
+		if ((best < 0) || (dist < best_dist)
+		    || ((dist == best_dist) && (offset < best_offset))) {
+			best = item;
+			best_dist = dist;
+			best_offset = offset;
 		}
-	} while (i != menu->cur_item);
+	}
 
-	menu->match_len = 0; /* match did not succeed - kill the match len. */
-	return E_NO_MATCH;
+	if (best < 0) {
+		menu->match_len = 0; /* match did not succeed */
+		return E_NO_MATCH;
+	}
+
+	*item_matched = best;
+	menu->match_len = menu->plen;
+	match->offset = best_offset;
+	return E_OK;
 }
 
 /*
@@ -379,6 +663,8 @@ _menui_match_items(MENU *menu, int direction, int *item_matched)
 int
 _menui_match_pattern(MENU *menu, int c, int direction, int *item_matched)
 {
+	int status;
+
 	if (menu == NULL)
 		return E_BAD_ARGUMENT;
 	if (menu->items == NULL)
@@ -390,9 +676,7 @@ _menui_match_pattern(MENU *menu, int c, int direction, int *item_matched)
 		  /* add char to buffer - first allocate room for it */
 		if ((menu->pattern = (char *)
 		     realloc(menu->pattern,
-			     menu->plen + sizeof(char) +
-			     ((menu->plen > 0)? 0 : 1)))
-		    == NULL)
+			     menu->plen + sizeof(char) + 1)) == NULL)
 			return E_SYSTEM_ERROR;
 		menu->pattern[menu->plen] = c;
 		menu->pattern[++menu->plen] = '\0';
@@ -404,10 +688,10 @@ _menui_match_pattern(MENU *menu, int c, int direction, int *item_matched)
 			return E_NO_MATCH;
 		}
 
-		if (_menui_match_items(menu, direction,
-					item_matched) == E_NO_MATCH) {
+		if ((status = _menui_match_items(menu, direction,
+						 item_matched)) != E_OK) {
 			menu->pattern[--menu->plen] = '\0';
-			return E_NO_MATCH;
+			return status;
 		} else
 			return E_OK;
 	} else {
@@ -428,6 +712,10 @@ _menui_draw_item(MENU *menu, int item)
 {
 	int j, pad_len, mark_len;
 
+	  /* nothing to draw if the item is scrolled out of the window */
+	if (!_menui_item_on_screen(menu, menu->items[item]))
+		return;
+
 	mark_len = max(menu->mark.length, menu->unmark.length);
 
 	wmove(menu->scrwin,
@@ -487,7 +775,6 @@ _menui_draw_item(MENU *menu, int item)
 		for (j = 0; j < pad_len; j++)
 			waddch(menu->scrwin, ' ');
 	}
-	menu->items[item]->visible = 1;
 
 	  /* kill any special attributes... */
 	wattrset(menu->scrwin, menu->back);
@@ -510,80 +797,113 @@ _menui_draw_item(MENU *menu, int item)
 }
 
 /*
- * Draw the menu in the subwindow provided.
+ * Return the index of the item at the given row and column of the menu
+ * layout or -1 if there is no item there.
  */
 int
-_menui_draw_menu(MENU *menu)
+_menui_item_at(MENU *menu, int row, int col)
 {
-	int rowmajor, i, j, k, row = -1, stride;
-	int incr, cur_row, offset, row_count;
+	int offset;
 
-	rowmajor = ((menu->opts & O_ROWMAJOR) == O_ROWMAJOR);
+	if ((row < 0) || (row >= menu->item_rows) || (col < 0)
+	    || (col >= menu->item_cols))
+		return -1;
 
-	if (rowmajor) {
-		stride = 1;
-		incr = menu->item_cols;
-	} else {
-		stride = menu->item_rows;
-		incr = 1;
-	}
-	row_count = 0;
-
-	for (i = 0;  i < menu->item_count; i += incr) {
-		if (menu->items[i]->row == menu->top_row)
-			break;
-		row_count++;
-		for (j = 0; j < menu->item_cols; j++) {
-			offset = j * stride + i;
-			if (offset >= menu->item_count)
-				break; /* done */
-			menu->items[offset]->visible = 0;
+	if ((menu->opts & O_ROWMAJOR) == O_ROWMAJOR)
+		offset = row * menu->item_cols + col;
+	else
+		offset = col * menu->item_rows + row;
+
+	if (offset >= menu->item_count)
+		return -1;
+
+	return offset;
+}
+
+/*
+ * Return TRUE if the item is on one of the menu rows currently displayed.
+ */
+int
+_menui_item_on_screen(MENU *menu, ITEM *item)
+{
+	return ((item->row >= menu->top_row)
+		&& (item->row < menu->top_row + menu->rows));
+}
+
+/*
+ * Draw the items on the given row of the menu, writing background
+ * blanks where the row has no item.  The row must be on the screen.
+ */
+static void
+_menui_draw_row(MENU *menu, int row)
+{
+	int j, k, offset;
+
+	for (j = 0; j < menu->cols; j++) {
+		offset = _menui_item_at(menu, row, j);
+		if (offset < 0) {
+			  /* no item here, write background blanks */
+			wattrset(menu->scrwin, menu->back);
+			wmove(menu->scrwin, row - menu->top_row,
+			      j * (menu->col_width + 1));
+			for (k = 0; k < menu->col_width; k++)
+				waddch(menu->scrwin, ' ');
+		} else {
+			_menui_draw_item(menu, offset);
 		}
 	}
+}
+
+/*
+ * Draw the menu in the subwindow provided.  Only the rows on the
+ * screen are touched so the cost does not depend on the number of
+ * items in the menu.
+ */
+int
+_menui_draw_menu(MENU *menu)
+{
+	int cur_row;
 
 	wmove(menu->scrwin, 0, 0);
 
 	menu->col_width = getmaxx(menu->scrwin) / menu->cols;
 
-	for (cur_row = 0; cur_row < menu->rows; cur_row++) {
-		for (j = 0; j < menu->cols; j++) {
-			offset = j * stride + i;
-			if (offset >= menu->item_count) {
-			   /* no more items to draw, write background blanks */
-				wattrset(menu->scrwin, menu->back);
-				if (row < 0) {
-					row = menu->items[menu->item_count - 1]->row;
-				}
+	for (cur_row = 0; cur_row < menu->rows; cur_row++)
+		_menui_draw_row(menu, menu->top_row + cur_row);
 
-				wmove(menu->scrwin, cur_row,
-				      j * (menu->col_width + 1));
-				for (k = 0; k < menu->col_width; k++)
-					waddch(menu->scrwin, ' ');
-			} else {
-				_menui_draw_item(menu, offset);
-			}
-		}
+	return E_OK;
+}
 
-		i += incr;
-		row_count++;
-	}
+/*
+ * Scroll the menu rows of the subwindow by lines, up if lines is
+ * positive or down if it is negative, leaving any part of the window
+ * below the menu where it was.  The rows scrolled onto the screen are
+ * left blank.
+ */
+static void
+_menui_scroll_menu(MENU *menu, int lines, int height)
+{
+	int below;
 
-	if (row_count < menu->item_rows) {
-		for (cur_row = row_count;  cur_row < menu->item_rows; cur_row++) {
-			for (j = 0; j < menu->item_cols; j++) {
-				offset = j * stride + i;
-				if (offset >= menu->item_count)
-					break; /* done */
-				menu->items[offset]->visible = 0;
-			}
-			i += incr;
+	below = (getmaxy(menu->scrwin) > height);
+
+	if (lines > 0) {
+		wmove(menu->scrwin, 0, 0);
+		winsdelln(menu->scrwin, -lines);
+		if (below) {
+			wmove(menu->scrwin, height - lines, 0);
+			winsdelln(menu->scrwin, lines);
 		}
+	} else {
+		if (below) {
+			wmove(menu->scrwin, height + lines, 0);
+			winsdelln(menu->scrwin, lines);
+		}
+		wmove(menu->scrwin, 0, 0);
+		winsdelln(menu->scrwin, -lines);
 	}
-
-	return E_OK;
 }
 
-
 /*
  * Calculate the widest menu item and stash it in the menu struct.
  *
@@ -607,28 +927,44 @@ _menui_max_item_size(MENU *menu)
 
 
 /*
- * Redraw the menu on the screen.  If the current item has changed then
- * unhighlight the old item and highlight the new one.
+ * Redraw the menu on the screen.  If the top row has moved by less than a
+ * screenful the rows still on the screen are scrolled into place and only
+ * the rows that come into view are drawn.  If the current item has changed
+ * then unhighlight the old item and highlight the new one.
  */
 static void
 _menui_redraw_menu(MENU *menu, int old_top_row, int old_cur_item)
 {
+	int shift, height, row, first, last;
 
-	if (menu->top_row != old_top_row) {
-		  /* top row changed - redo the whole menu
-		   * XXXX this could be improved if we had wscrl implemented.
+	shift = menu->top_row - old_top_row;
+	height = min(menu->rows, getmaxy(menu->scrwin));
 
-		   * XXXX we could scroll the window and just fill in the
-		   * XXXX changed lines.
-		   */
+	if ((shift >= height) || (-shift >= height)) {
+		  /* nothing left to keep - redo the whole menu */
 		wclear(menu->scrwin);
 		_menui_draw_menu(menu);
-	} else {
-		if (menu->cur_item != old_cur_item) {
-			  /* redo the old item as a normal one. */
-			_menui_draw_item(menu, old_cur_item);
+		return;
+	}
+
+	if (shift != 0) {
+		_menui_scroll_menu(menu, shift, height);
+		if (shift > 0) {
+			first = height - shift;
+			last = height;
+		} else {
+			first = 0;
+			last = -shift;
 		}
-		  /* and then redraw the current item */
-		_menui_draw_item(menu, menu->cur_item);
+
+		for (row = first; row < last; row++)
+			_menui_draw_row(menu, menu->top_row + row);
+	}
+
+	if (menu->cur_item != old_cur_item) {
+		  /* redo the old item as a normal one. */
+		_menui_draw_item(menu, old_cur_item);
 	}
+	  /* and then redraw the current item */
+	_menui_draw_item(menu, menu->cur_item);
 }
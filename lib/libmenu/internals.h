@@ -38,15 +38,44 @@
 
 /* stole this from curses.h */
 #define max(a,b)        ((a) > (b) ? a : b)
+#define min(a,b)        ((a) < (b) ? a : b)
+
+/*
+ * The pattern match index, a key is an item name or a suffix of one.
+ */
+struct _menui_key {
+	const char *key; /* start of the key in the item name */
+	int len; /* length of the key */
+	int item; /* index of the item the key belongs to */
+	int offset; /* offset of the key into the item name */
+};
+
+struct _menui_match {
+	int caseless; /* keys are sorted ignoring case */
+	int substring; /* keys include every suffix of the item names */
+	int count; /* number of keys */
+	struct _menui_key *keys; /* the sorted keys */
+	int depth; /* length of the pattern matched by the range */
+	int lo; /* first key matching the pattern */
+	int hi; /* one past the last key matching the pattern */
+	int offset; /* offset of the last match into the item name */
+};
 
 /* function prototypes */
 
 void _menui_draw_item(MENU *menu, int item);
 int _menui_draw_menu(MENU *menu);
 int _menui_goto_item(MENU *menu, ITEM *item, int new_top_row);
+int _menui_item_at(MENU *menu, int row, int col);
+int _menui_item_on_screen(MENU *menu, ITEM *item);
 int _menui_match_pattern(MENU *menu, int c, int direction ,
 			 int *item_matched);
 int _menui_match_items(MENU *menu, int direction, int *item_matched);
+unsigned int *_menui_new_selection(ITEM **items, int count, int *sel_count);
+int _menui_next_selected(MENU *menu, int item);
+void _menui_select_item(MENU *menu, ITEM *item, int flag);
+void _menui_free_match(MENU *menu);
+void _menui_reset_match(MENU *menu);
 void _menui_max_item_size(MENU *menu);
 int _menui_stitch_items(MENU *menu);
 
@@ -53,7 +53,8 @@ ITEM _menui_default_item = {
 };
 
 /*
- * Return the item visibility flag
+ * Return TRUE if the item is on the part of the posted menu that is on
+ * the screen.
  */
 int
 item_visible(ITEM *item)
@@ -63,7 +64,10 @@ item_visible(ITEM *item)
 	if (item->parent == NULL)
 		return E_NOT_CONNECTED;
 	
-        return item->visible;
+	if (item->parent->posted == 0)
+		return 0;
+
+        return _menui_item_on_screen(item->parent, item);
 }
 
 /*
@@ -156,26 +160,53 @@ item_selected(MENU *menu, int **sel)
 	if (menu == NULL)
 		return E_BAD_ARGUMENT;
 
-	/* count selected */
-	for (i = 0, j = 0; i < menu->item_count; i++)
-		if (menu->items[i]->selected)
-			j++;
-
-	if (j == 0) {
+	if (menu->sel_count == 0) {
 		*sel = NULL;
 		return 0;
 	}
 	
-	if ( (*sel = malloc(sizeof(int) * j)) == NULL)
+	if ( (*sel = malloc(sizeof(int) * menu->sel_count)) == NULL)
 		return E_SYSTEM_ERROR;
 
-	for (i = 0, j = 0; i < menu->item_count; i++)
-		if (menu->items[i]->selected)
-			(*sel)[j++] = i;
+	for (i = _menui_next_selected(menu, -1), j = 0; i >= 0;
+	     i = _menui_next_selected(menu, i))
+		(*sel)[j++] = i;
 
 	return j;
 }
 
+/*
+ * Returns the number of items that are selected without building a list
+ * of them.
+ */
+int
+item_selected_count(MENU *menu)
+{
+	if (menu == NULL)
+		return E_BAD_ARGUMENT;
+
+	return menu->sel_count;
+}
+
+/*
+ * Returns the index of the first selected item after the given item
+ * index, an index of -1 returns the first selected item.  E_NO_MATCH is
+ * returned when there are no more selected items.
+ */
+int
+item_selected_next(MENU *menu, int item)
+{
+	if ((menu == NULL) || (item < -1))
+		return E_BAD_ARGUMENT;
+	if (menu->items == NULL)
+		return E_NOT_CONNECTED;
+
+	if ((item = _menui_next_selected(menu, item)) < 0)
+		return E_NO_MATCH;
+
+	return item;
+}
+
 /*
  * Set the item options.  We keep a global copy of the current item options
  * as subsequent new_item calls will use the updated options as their
@@ -255,7 +286,7 @@ set_item_value(ITEM *param_item, int flag)
         if ((item->parent->opts & O_ONEVALUE) == O_ONEVALUE)
                 return E_REQUEST_DENIED;
 
-        item->selected = flag;
+	_menui_select_item(item->parent, item, flag);
 	_menui_draw_item(item->parent, item->index);
         return E_OK;
 }
@@ -65,6 +65,7 @@ MENU _menui_default_menu = {
         NULL,       /* the menu window */
 	NULL,       /* the menu subwindow */
 	NULL,       /* the window to write to */
+	NULL,       /* pattern match index */
 };
 
 
@@ -300,7 +301,7 @@ menu_opts(MENU *menu)
 int
 set_menu_opts(MENU *param_menu, OPTIONS opts)
 {
-	int i, seen;
+	int i;
 	MENU *menu = (param_menu != NULL) ? param_menu : &_menui_default_menu;
 	OPTIONS old_opts = menu->opts;
 	
@@ -312,20 +313,14 @@ set_menu_opts(MENU *param_menu, OPTIONS opts)
 	   */
 	if (((opts & O_RADIO) == O_RADIO) && (menu->items != NULL) &&
 	    (menu->items[0] != NULL)) {
-		seen = 0;
-		for (i = 0; i < menu->item_count; i++) {
-			if (menu->items[i]->selected == 1) {
-				if (seen == 0) {
-					seen = 1;
-				} else {
-					menu->items[i]->selected = 0;
-				}
-			}
+		  /* keep the first selected item, deselect the rest */
+		if ((i = _menui_next_selected(menu, -1)) >= 0) {
+			while ((i = _menui_next_selected(menu, i)) >= 0)
+				_menui_select_item(menu, menu->items[i], 0);
+		} else {
+			  /* if none selected, select the first item */
+			_menui_select_item(menu, menu->items[0], 1);
 		}
-
-		  /* if none selected, select the first item */
-		if (seen == 0)
-			menu->items[0]->selected = 1;
 	}
 
  	if ((menu->opts & O_ROWMAJOR) != (old_opts &  O_ROWMAJOR))
@@ -341,7 +336,7 @@ set_menu_opts(MENU *param_menu, OPTIONS opts)
 int
 menu_opts_on(MENU *param_menu, OPTIONS opts)
 {
-	int i, seen;
+	int i;
 	MENU *menu = (param_menu != NULL) ? param_menu : &_menui_default_menu;
 	OPTIONS old_opts = menu->opts;
 
@@ -353,19 +348,14 @@ menu_opts_on(MENU *param_menu, OPTIONS opts)
 	   */
 	if (((opts & O_RADIO) == O_RADIO) && (menu->items != NULL) &&
 	    (menu->items[0] != NULL)) {
-		seen = 0;
-		for (i = 0; i < menu->item_count; i++) {
-			if (menu->items[i]->selected == 1) {
-				if (seen == 0) {
-					seen = 1;
-				} else {
-					menu->items[i]->selected = 0;
-				}
-			}
+		  /* keep the first selected item, deselect the rest */
+		if ((i = _menui_next_selected(menu, -1)) >= 0) {
+			while ((i = _menui_next_selected(menu, i)) >= 0)
+				_menui_select_item(menu, menu->items[i], 0);
+		} else {
+			  /* if none selected then select the top item */
+			_menui_select_item(menu, menu->items[0], 1);
 		}
-		  /* if none selected then select the top item */
-		if (seen == 0)
-			menu->items[0]->selected = 1;
 	}
 
 	if ((menu->items != NULL) &&
@@ -427,6 +417,7 @@ set_menu_pattern(MENU *param_menu, char *pat)
 
         strcpy(menu->pattern, pat);
 	menu->plen = strlen(pat);
+	_menui_reset_match(menu);
 	
           /* search item list for pat here */
 	return _menui_match_items(menu, MATCH_FORWARD, &menu->cur_item);
@@ -446,6 +437,9 @@ new_menu(ITEM **items)
 
           /* copy the defaults */
 	(void)memcpy(the_menu, &_menui_default_menu, sizeof(MENU));
+	the_menu->match = NULL; /* built for this menu when needed */
+	the_menu->sel_map = NULL; /* the selections are per menu too */
+	the_menu->sel_count = 0;
 
 	  /* set a default window if none already set. */
 	if (the_menu->menu_win == NULL)
@@ -511,6 +505,9 @@ free_menu(MENU *menu)
 	if (menu->pattern != NULL)
 		free(menu->pattern);
 
+	_menui_free_match(menu);
+	free(menu->sel_map);
+
 	if (menu->mark.string != NULL)
 		free(menu->mark.string);
 
@@ -558,6 +555,7 @@ set_menu_items(MENU *param_menu, ITEM **items)
 {
 	MENU *menu = (param_menu != NULL) ? param_menu : &_menui_default_menu;
 	int i, new_count = 0, sel_count = 0;
+	unsigned int *sel_map;
 	
 	  /* don't change if menu is posted */
 	if (menu->posted == 1)
@@ -581,6 +579,10 @@ set_menu_items(MENU *param_menu, ITEM **items)
 	    (sel_count > 1))
 		return E_BAD_ARGUMENT;
 	
+	if ((sel_map = _menui_new_selection(items, new_count, &sel_count))
+	    == NULL)
+		return E_SYSTEM_ERROR;
+
 	  /* if there were items connected then disconnect them. */
 	if (menu->items != NULL) {
 		for (i = 0; i < menu->item_count; i++) {
@@ -598,20 +600,25 @@ set_menu_items(MENU *param_menu, ITEM **items)
 	}
 
 	menu->items = items;
+	free(menu->sel_map);
+	menu->sel_map = sel_map;
+	menu->sel_count = sel_count;
 	menu->cur_item = 0; /* reset current item just in case */
 	menu->top_row = 0; /* and the top row too */
 	if (menu->pattern != NULL) { /* and the pattern buffer....sigh */
 		free(menu->pattern);
+		menu->pattern = NULL;
 		menu->plen = 0;
 		menu->match_len = 0;
 	}
+	_menui_free_match(menu); /* the match index is for the old items */
 	
 	  /*
 	   * make sure at least one item is selected on a radio
 	   * button style menu.
 	   */
 	if (((menu->opts & O_RADIO) == O_RADIO) && (sel_count == 0))
-		menu->items[0]->selected = 1;
+		_menui_select_item(menu, menu->items[0], 1);
 	
 	
 	_menui_stitch_items(menu); /* recalculate the item neighbours */
@@ -651,7 +658,7 @@ int
 set_top_row(MENU *param_menu, int row)
 {
 	MENU *menu = (param_menu != NULL) ? param_menu : &_menui_default_menu;
-	int i, cur_item, state = E_SYSTEM_ERROR;
+	int cur_item, state = E_SYSTEM_ERROR;
 	
 	if (row > menu->item_rows)
 		return E_BAD_ARGUMENT;
@@ -662,17 +669,11 @@ set_top_row(MENU *param_menu, int row)
 	if (menu->in_init == 1)
 		return E_BAD_STATE;
 
-	cur_item = 0;
-	
-	for (i = 0; i < menu->item_count; i++) {
-		  /* search for first item that matches row - this will be
-		     the current item. */
-		if (row == menu->items[i]->row) {
-			cur_item = i;
-			state = E_OK;
-			break; /* found what we want - no need to go further */
-		}
-	}
+	  /* the first item on the row will be the current item. */
+	if ((cur_item = _menui_item_at(menu, row, 0)) < 0)
+		cur_item = 0;
+	else
+		state = E_OK;
 
 	menu->in_init = 1; /* just in case we call the init/term routines */
 	
@@ -687,6 +688,10 @@ set_top_row(MENU *param_menu, int row)
 	menu->top_row = row;
 
 	if (menu->posted == 1) {
+		  /* the screen must match the top row for later scrolling */
+		werase(menu->scrwin);
+		_menui_draw_menu(menu);
+
 		if (menu->menu_init != NULL)
 			menu->menu_init(menu);
 		if (menu->item_init != NULL)
@@ -729,8 +734,11 @@ pos_menu_cursor(MENU *menu)
 	movx = maxmark + (menu->items[menu->cur_item]->col
 		* (menu->col_width + 1));
 	
-	if (menu->match_len > 0)
+	if (menu->match_len > 0) {
 		movx += menu->match_len - 1;
+		if (menu->match != NULL)
+			movx += menu->match->offset;
+	}
 	
 	wmove(menu->scrwin,
 	      menu->items[menu->cur_item]->row - menu->top_row, movx);
@@ -68,6 +68,7 @@ typedef unsigned int OPTIONS;
 #define O_NONCYCLIC  (0x20)
 #define O_SELECTABLE (0x40)
 #define O_RADIO      (0x80)
+#define O_SUBSTRING  (0x100)
 
 typedef struct __menu_str {
         char *string;
@@ -83,7 +84,7 @@ struct __item {
         MENU_STR name;
         MENU_STR description;
         char *userptr;
-        int visible;  /* set if item is visible */
+        int visible;  /* unused, see item_visible() */
         int selected; /* set if item has been selected */
 	int row; /* menu row this item is on */
 	int col; /* menu column this item is on */
@@ -134,6 +135,9 @@ struct __menu {
         WINDOW *menu_win; /* the menu window */
         WINDOW *menu_subwin; /* the menu subwindow */
 	WINDOW *scrwin; /* the window to write to */
+	struct _menui_match *match; /* index for pattern matching */
+	unsigned int *sel_map; /* bitmap of the selected items */
+	int sel_count; /* number of items selected */
 };
 
 
@@ -191,6 +195,8 @@ OPTIONS item_opts(ITEM *);
 int item_opts_off(ITEM *, OPTIONS);
 int item_opts_on(ITEM *, OPTIONS);
 int item_selected(MENU *, int **); /* return the item index of selected */
+int item_selected_count(MENU *);
+int item_selected_next(MENU *, int);
 Menu_Hook item_term(MENU *);
 char *item_userptr(ITEM *);
 int item_value(ITEM *);
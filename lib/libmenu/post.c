@@ -66,9 +66,9 @@ post_menu(MENU *menu)
 		return E_NO_ROOM;
 
 	if ((menu->opts & O_RADIO) != O_RADIO) {
-		for (i = 0; i < menu->item_count; i++) {
-			menu->items[i]->selected = 0;
-		}
+		for (i = _menui_next_selected(menu, -1); i >= 0;
+		     i = _menui_next_selected(menu, i))
+			_menui_select_item(menu, menu->items[i], 0);
 	}
 	
 	menu->posted = 1;
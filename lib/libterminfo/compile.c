@@ -45,11 +45,13 @@
 #include <term.h>
 
 static void
-dowarn(int flags, const char *fmt, ...)
+dowarn(TIC *tic, int flags, const char *fmt, ...)
 {
 	va_list va;
 
 	errno = EINVAL;
+	if (tic != NULL)
+		tic->warnings++;
 	if (flags & TIC_WARNING) {
 		va_start(va, fmt);
 		vwarnx(fmt, va);
@@ -300,7 +302,7 @@ _ti_store_extra(TIC *tic, int wrn, const char *id, char type, char flag,
 			return 0;
 		if (!(flags & TIC_EXTRA)) {
 			if (wrn != 0)
-				dowarn(flags, "%s: %s: unknown capability",
+				dowarn(tic, flags, "%s: %s: unknown capability",
 				    tic->name, id);
 			return 0;
 		}
@@ -308,7 +310,8 @@ _ti_store_extra(TIC *tic, int wrn, const char *id, char type, char flag,
 
 	l = strlen(id) + 1;
 	if (l > UINT16_MAX) {
-		dowarn(flags, "%s: %s: cap name is too long", tic->name, id);
+		dowarn(tic, flags, "%s: %s: cap name is too long",
+		    tic->name, id);
 		return 0;
 	}
 
@@ -404,8 +407,281 @@ _ti_flatten(uint8_t **buf, const TIC *tic)
 	return (uint8_t *)cap - *buf;
 }
 
+struct tipool_slot {
+	uint32_t hash;
+	uint32_t off;	/* 0 is unused as it's the pool header byte */
+	size_t len;
+};
+
+static uint32_t
+_ti_pool_hash(const char *str, size_t len)
+{
+	uint32_t hash;
+
+	/* FNV-1a */
+	hash = 2166136261U;
+	while (len-- != 0) {
+		hash ^= (uint8_t)*str++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static int
+_ti_pool_grow(TIPOOL *pool)
+{
+	struct tipool_slot *slots, *slot;
+	size_t i, j, nslots;
+
+	nslots = pool->nslots == 0 ? 1024 : pool->nslots * 2;
+	slots = calloc(nslots, sizeof(*slots));
+	if (slots == NULL)
+		return -1;
+	for (i = 0; i < pool->nslots; i++) {
+		slot = &pool->slots[i];
+		if (slot->off == 0)
+			continue;
+		for (j = slot->hash & (nslots - 1);
+		    slots[j].off != 0;
+		    j = (j + 1) & (nslots - 1))
+			continue;
+		slots[j] = *slot;
+	}
+	free(pool->slots);
+	pool->slots = slots;
+	pool->nslots = nslots;
+	return 0;
+}
+
+/* Store str in the pool if it's not already there and return its offset. */
+static int
+_ti_pool_add(TIPOOL *pool, const char *str, size_t len, uint32_t *offp)
+{
+	struct tipool_slot *slot;
+	uint32_t hash;
+	size_t i;
+
+	if (pool->buf.entries * 2 >= pool->nslots && _ti_pool_grow(pool) == -1)
+		return -1;
+
+	hash = _ti_pool_hash(str, len);
+	for (i = hash & (pool->nslots - 1);
+	    pool->slots[i].off != 0;
+	    i = (i + 1) & (pool->nslots - 1))
+	{
+		slot = &pool->slots[i];
+		if (slot->hash == hash && slot->len == len &&
+		    memcmp(pool->buf.buf + slot->off, str, len) == 0)
+		{
+			*offp = slot->off;
+			return 0;
+		}
+	}
+
+	if (pool->buf.bufpos == 0) {
+		if (!_ti_grow_tbuf(&pool->buf, 1))
+			return -1;
+		pool->buf.buf[pool->buf.bufpos++] = TERMINFO_POOL;
+	}
+	if (len > UINT32_MAX - pool->buf.bufpos) {
+		errno = E2BIG;
+		return -1;
+	}
+	/* Grow by at least the current size to avoid a realloc per string */
+	if (!_ti_grow_tbuf(&pool->buf,
+	    len > pool->buf.bufpos ? len : pool->buf.bufpos))
+		return -1;
+	memcpy(pool->buf.buf + pool->buf.bufpos, str, len);
+	slot = &pool->slots[i];
+	slot->hash = hash;
+	slot->off = (uint32_t)pool->buf.bufpos;
+	slot->len = len;
+	pool->buf.bufpos += len;
+	pool->buf.entries++;
+	*offp = slot->off;
+	return 0;
+}
+
+/*
+ * Load an existing string pool into an empty pool so that new
+ * descriptions share its strings, which keep their offsets.
+ */
+int
+_ti_loadpool(TIPOOL *pool, const void *data, size_t len)
+{
+	struct tipool_slot *slot;
+	const char *str, *end, *p;
+	uint32_t hash;
+	size_t i, slen;
+
+	assert(pool != NULL);
+	assert(data != NULL);
+
+	if (len == 0 || *(const char *)data != TERMINFO_POOL ||
+	    len > UINT32_MAX)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	if (!_ti_grow_tbuf(&pool->buf, len))
+		return -1;
+	memcpy(pool->buf.buf, data, len);
+	pool->buf.bufpos = len;
+
+	end = pool->buf.buf + len;
+	for (str = pool->buf.buf + 1; str < end; str += slen) {
+		p = memchr(str, '\0', (size_t)(end - str));
+		if (p == NULL)
+			break;
+		slen = (size_t)(p - str) + 1;
+		if (pool->buf.entries * 2 >= pool->nslots &&
+		    _ti_pool_grow(pool) == -1)
+			return -1;
+		hash = _ti_pool_hash(str, slen);
+		for (i = hash & (pool->nslots - 1);
+		    pool->slots[i].off != 0;
+		    i = (i + 1) & (pool->nslots - 1))
+		{
+			slot = &pool->slots[i];
+			if (slot->hash == hash && slot->len == slen &&
+			    memcmp(pool->buf.buf + slot->off, str, slen) == 0)
+				break;
+		}
+		slot = &pool->slots[i];
+		if (slot->off != 0)
+			continue;
+		slot->hash = hash;
+		slot->off = (uint32_t)(str - pool->buf.buf);
+		slot->len = slen;
+		pool->buf.entries++;
+	}
+	return 0;
+}
+
+/* Encode a string or extras section, moving the strings into the pool. */
+static int
+_ti_encode_pooled(char **cap, const TIC *tic, const TBUF *buf, int extras,
+    TIPOOL *pool)
+{
+	const char *str;
+	char *size, *start;
+	uint16_t len;
+	uint32_t off;
+	size_t n;
+
+	if (buf->entries == 0) {
+		_ti_encode_16(cap, 0);
+		return 0;
+	}
+
+	size = *cap;
+	*cap += sizeof(uint16_t);
+	start = *cap;
+	_ti_encode_16(cap, buf->entries);
+	str = buf->buf;
+	for (n = buf->entries; n > 0; n--) {
+		if (extras) {
+			len = _ti_decode_16(&str);
+			_ti_encode_count_str(cap, str, len);
+			str += len;
+			**cap = *str;
+			(*cap)++;
+			switch (*str++) {
+			case 'f':
+				_ti_encode_str(cap, str, 1);
+				str++;
+				continue;
+			case 'n':
+				_ti_encode_str(cap, str, _ti_numsize(tic));
+				str += _ti_numsize(tic);
+				continue;
+			}
+		} else {
+			_ti_encode_str(cap, str, sizeof(uint16_t));
+			str += sizeof(uint16_t);
+		}
+		len = _ti_decode_16(&str);
+		_ti_encode_16(cap, len);
+		if (len == 0)
+			continue;
+		if (_ti_pool_add(pool, str, len, &off) == -1)
+			return -1;
+		_ti_encode_32(cap, off);
+		str += len;
+	}
+	if ((size_t)(*cap - start) > UINT16_MAX) {
+		errno = E2BIG;
+		return -1;
+	}
+	_ti_encode_16(&size, (size_t)(*cap - start));
+	return 0;
+}
+
+/*
+ * Flatten tic as a type 4 description, adding its strings to pool
+ * which is stored in the database as poolid.
+ */
+ssize_t
+_ti_flatten_pooled(uint8_t **buf, const TIC *tic, TIPOOL *pool,
+    uint32_t poolid)
+{
+	size_t buflen, len, alen, dlen;
+	char *cap;
+
+	assert(buf != NULL);
+	assert(tic != NULL);
+	assert(pool != NULL);
+
+	len = strlen(tic->name) + 1;
+	if (tic->alias == NULL)
+		alen = 0;
+	else
+		alen = strlen(tic->alias) + 1;
+	if (tic->desc == NULL)
+		dlen = 0;
+	else
+		dlen = strlen(tic->desc) + 1;
+
+	/* A pooled string takes at most four bytes more than it did. */
+	buflen = sizeof(char) + sizeof(uint32_t) + sizeof(char) +
+	    sizeof(uint16_t) + len +
+	    sizeof(uint16_t) + alen +
+	    sizeof(uint16_t) + dlen +
+	    (sizeof(uint16_t) * 2) + tic->flags.bufpos +
+	    (sizeof(uint16_t) * 2) + tic->nums.bufpos +
+	    (sizeof(uint16_t) * 2) + tic->strs.bufpos +
+	    tic->strs.entries * sizeof(uint32_t) +
+	    (sizeof(uint16_t) * 2) + tic->extras.bufpos +
+	    tic->extras.entries * sizeof(uint32_t);
+
+	*buf = malloc(buflen);
+	if (*buf == NULL)
+		return -1;
+
+	cap = (char *)*buf;
+	*cap++ = TERMINFO_RTYPE_POOLED;
+	_ti_encode_32(&cap, poolid);
+	*cap++ = tic->rtype;
+
+	_ti_encode_count_str(&cap, tic->name, len);
+	_ti_encode_count_str(&cap, tic->alias, alen);
+	_ti_encode_count_str(&cap, tic->desc, dlen);
+
+	_ti_encode_buf(&cap, &tic->flags);
+	_ti_encode_buf(&cap, &tic->nums);
+	if (_ti_encode_pooled(&cap, tic, &tic->strs, 0, pool) == -1 ||
+	    _ti_encode_pooled(&cap, tic, &tic->extras, 1, pool) == -1)
+	{
+		free(*buf);
+		*buf = NULL;
+		return -1;
+	}
+
+	return (uint8_t *)cap - *buf;
+}
+
 static int
-encode_string(const char *term, const char *cap, TBUF *tbuf, const char *str,
+encode_string(TIC *tic, const char *cap, TBUF *tbuf, const char *str,
     int flags)
 {
 	int slash, i, num;
@@ -433,9 +709,9 @@ encode_string(const char *term, const char *cap, TBUF *tbuf, const char *str,
 			if (last != '%' && ch == '^') {
 				ch = *str++;
 				if (((unsigned char)ch) >= 128)
-					dowarn(flags,
+					dowarn(tic, flags,
 					    "%s: %s: illegal ^ character",
-					    term, cap);
+					    tic->name, cap);
 				if (ch == '\0')
 					break;
 				if (ch == '?')
@@ -443,9 +719,9 @@ encode_string(const char *term, const char *cap, TBUF *tbuf, const char *str,
 				else if ((ch &= 037) == 0)
 					ch = (char)128;
 			} else if (!isprint((unsigned char)ch))
-				dowarn(flags,
+				dowarn(tic, flags,
 				    "%s: %s: unprintable character",
-				    term, cap);
+				    tic->name, cap);
 			*p++ = ch;
 			last = ch;
 			continue;
@@ -456,9 +732,9 @@ encode_string(const char *term, const char *cap, TBUF *tbuf, const char *str,
 			for (i = 0; i < 2; i++) {
 				if (*str < '0' || *str > '7') {
 					if (isdigit((unsigned char)*str))
-						dowarn(flags,
+						dowarn(tic, flags,
 						    "%s: %s: non octal"
-						    " digit", term, cap);
+						    " digit", tic->name, cap);
 					else
 						break;
 				}
@@ -598,7 +874,7 @@ _ti_compile(char *cap, int flags)
 
 	name = _ti_get_token(&cap, ',');
 	if (name == NULL) {
-		dowarn(flags, "no separator found: %s", cap);
+		dowarn(NULL, flags, "no separator found: %s", cap);
 		return NULL;
 	}
 	desc = strrchr(name, '|');
@@ -609,15 +885,15 @@ _ti_compile(char *cap, int flags)
 		*alias++ = '\0';
 
 	if (strlen(name) > UINT16_MAX - 1) {
-		dowarn(flags, "%s: name too long", name);
+		dowarn(NULL, flags, "%s: name too long", name);
 		return NULL;
 	}
 	if (desc != NULL && strlen(desc) > UINT16_MAX - 1) {
-		dowarn(flags, "%s: description too long: %s", name, desc);
+		dowarn(NULL, flags, "%s: description too long: %s", name, desc);
 		return NULL;
 	}
 	if (alias != NULL && strlen(alias) > UINT16_MAX - 1) {
-		dowarn(flags, "%s: alias too long: %s", name, alias);
+		dowarn(NULL, flags, "%s: alias too long: %s", name, alias);
 		return NULL;
 	}
 
@@ -674,16 +950,16 @@ _ti_compile(char *cap, int flags)
 
 			/* Encode the string to our scratch buffer */
 			buf.bufpos = 0;
-			if (encode_string(tic->name, token,
+			if (encode_string(tic, token,
 				&buf, p, flags) == -1)
 				goto error;
 			if (buf.bufpos > UINT16_MAX - 1) {
-				dowarn(flags, "%s: %s: string is too long",
+				dowarn(tic, flags, "%s: %s: string is too long",
 				    tic->name, token);
 				continue;
 			}
 			if (!VALID_STRING(buf.buf)) {
-				dowarn(flags, "%s: %s: invalid string",
+				dowarn(tic, flags, "%s: %s: invalid string",
 				    tic->name, token);
 				continue;
 			}
@@ -712,12 +988,13 @@ _ti_compile(char *cap, int flags)
 
 			cnum = strtol(p, &e, 0);
 			if (*e != '\0') {
-				dowarn(flags, "%s: %s: not a number",
+				dowarn(tic, flags, "%s: %s: not a number",
 				    tic->name, token);
 				continue;
 			}
 			if (!VALID_NUMERIC(cnum) || cnum > INT32_MAX) {
-				dowarn(flags, "%s: %s: number %ld out of range",
+				dowarn(tic, flags,
+				    "%s: %s: number %ld out of range",
 				    tic->name, token, cnum);
 				continue;
 			}
@@ -804,3 +1081,12 @@ _ti_freetic(TIC *tic)
 		free(tic);
 	}
 }
+
+void
+_ti_freepool(TIPOOL *pool)
+{
+
+	free(pool->buf.buf);
+	free(pool->slots);
+	memset(pool, 0, sizeof(*pool));
+}
@@ -74,20 +74,182 @@ allocset(void *pp, int init, size_t nelem, size_t elemsize)
 	return 0;
 }
 
+/*
+ * Expand a string or extras section of a type 4 description from cap
+ * into dst, returning the length of the expanded section.
+ * If dst is NULL then only the length is worked out.
+ */
+static ssize_t
+_ti_unpool_section(char *dst, const char **capp, const char *end, int rtype,
+    int extras, const char *pool, size_t poollen)
+{
+	const char *cap, *id;
+	char *p, *size;
+	uint16_t entries, len;
+	uint32_t off;
+	size_t total, numsize;
+
+#define	NEED(n)	if ((size_t)(end - cap) < (n)) return -1
+	cap = *capp;
+	p = size = dst;
+	NEED(sizeof(uint16_t));
+	if (_ti_decode_16(&cap) == 0) {
+		if (dst != NULL)
+			_ti_encode_16(&p, 0);
+		*capp = cap;
+		return sizeof(uint16_t);
+	}
+	NEED(sizeof(uint16_t));
+	entries = _ti_decode_16(&cap);
+	total = sizeof(uint16_t) * 2;
+	if (dst != NULL) {
+		p += sizeof(uint16_t);
+		_ti_encode_16(&p, entries);
+	}
+	numsize = rtype == TERMINFO_RTYPE_O1 ?
+	    sizeof(uint16_t) : sizeof(uint32_t);
+	for (; entries != 0; entries--) {
+		if (extras) {
+			NEED(sizeof(uint16_t));
+			len = _ti_decode_16(&cap);
+			NEED((size_t)len + 1);
+			id = cap;
+			cap += len;
+			total += sizeof(uint16_t) + len + 1;
+			if (dst != NULL) {
+				_ti_encode_count_str(&p, id, len);
+				*p++ = *cap;
+			}
+			switch (*cap++) {
+			case 'f':
+				len = 1;
+				break;
+			case 'n':
+				len = numsize;
+				break;
+			case 's':
+				len = 0;
+				break;
+			default:
+				return -1;
+			}
+			if (len != 0) {
+				NEED(len);
+				total += len;
+				if (dst != NULL)
+					_ti_encode_str(&p, cap, len);
+				cap += len;
+				continue;
+			}
+		} else {
+			NEED(sizeof(uint16_t));
+			total += sizeof(uint16_t);
+			if (dst != NULL)
+				_ti_encode_str(&p, cap, sizeof(uint16_t));
+			cap += sizeof(uint16_t);
+		}
+		NEED(sizeof(uint16_t));
+		len = _ti_decode_16(&cap);
+		total += sizeof(uint16_t) + len;
+		if (len == 0) {
+			if (dst != NULL)
+				_ti_encode_16(&p, 0);
+			continue;
+		}
+		NEED(sizeof(uint32_t));
+		off = (uint32_t)_ti_decode_32(&cap);
+		if (off > poollen || len > poollen - off)
+			return -1;
+		if (dst != NULL)
+			_ti_encode_count_str(&p, pool + off, len);
+	}
+#undef NEED
+	if (dst != NULL)
+		_ti_encode_16(&size, total - sizeof(uint16_t));
+	*capp = cap;
+	return (ssize_t)total;
+}
+
+/*
+ * Expand a type 4 description into the terminal's storage area
+ * as the type 1 or 3 description it was made from.
+ * Returns the type of the expanded description or -1 on error.
+ */
 static int
-_ti_readterm(TERMINAL *term, const char *cap, size_t caplen, int flags)
+_ti_unpool(TERMINAL *term, const char *cap, size_t caplen,
+    const char *pool, size_t poollen)
+{
+	const char *end, *start, *sect;
+	char rtype;
+	uint16_t len;
+	ssize_t slen, elen;
+	size_t dlen;
+	int i;
+
+	end = cap + caplen;
+	if (pool == NULL || caplen < sizeof(uint32_t) + 1)
+		goto out;
+	/* The caller has already found the pool from its id */
+	cap += sizeof(uint32_t);
+	rtype = *cap++;
+	if (rtype != TERMINFO_RTYPE && rtype != TERMINFO_RTYPE_O1)
+		goto out;
+
+	/* Name, alias, description, flags and numbers are stored as is. */
+	start = cap;
+	for (i = 0; i < 5; i++) {
+		if ((size_t)(end - cap) < sizeof(uint16_t))
+			goto out;
+		len = _ti_decode_16(&cap);
+		if ((size_t)(end - cap) < len)
+			goto out;
+		cap += len;
+	}
+	dlen = (size_t)(cap - start);
+
+	sect = cap;
+	slen = _ti_unpool_section(NULL, &sect, end, rtype, 0, pool, poollen);
+	if (slen == -1)
+		goto out;
+	elen = _ti_unpool_section(NULL, &sect, end, rtype, 1, pool, poollen);
+	if (elen == -1)
+		goto out;
+
+	if (term->_arealen != dlen + (size_t)slen + (size_t)elen) {
+		term->_arealen = dlen + (size_t)slen + (size_t)elen;
+		term->_area = realloc(term->_area, term->_arealen);
+		if (term->_area == NULL)
+			return -1;
+	}
+	memcpy(term->_area, start, dlen);
+	sect = cap;
+	_ti_unpool_section(term->_area + dlen, &sect, end, rtype, 0,
+	    pool, poollen);
+	_ti_unpool_section(term->_area + dlen + slen, &sect, end, rtype, 1,
+	    pool, poollen);
+	return rtype;
+out:
+	errno = EINVAL;
+	return -1;
+}
+
+static int
+_ti_readterm(TERMINAL *term, const char *cap, size_t caplen,
+    const char *pool, size_t poollen, int flags)
 {
 	char rtype;
 	uint16_t ind, num;
 	size_t len;
+	int r;
 	TERMUSERDEF *ud;
 
 	if (caplen == 0)
 		goto out;
 	rtype = *cap++;
 	caplen--;
-	/* Only read type 1 or 3 records */
-	if (rtype != TERMINFO_RTYPE && rtype != TERMINFO_RTYPE_O1)
+	/* Only read type 1, 3 or 4 records */
+	if (rtype != TERMINFO_RTYPE && rtype != TERMINFO_RTYPE_O1 &&
+	    rtype != TERMINFO_RTYPE_POOLED)
 		goto out;
 
 	if (allocset(&term->flags, 0, TIFLAGMAX+1, sizeof(*term->flags)) == -1)
@@ -99,13 +261,19 @@ _ti_readterm(TERMINAL *term, const char *cap, size_t caplen, int flags)
 	if (allocset(&term->strs, 0, TISTRMAX+1, sizeof(*term->strs)) == -1)
 		return -1;
 
-	if (term->_arealen != caplen) {
-		term->_arealen = caplen;
-		term->_area = realloc(term->_area, term->_arealen);
-		if (term->_area == NULL)
+	if (rtype == TERMINFO_RTYPE_POOLED) {
+		if ((r = _ti_unpool(term, cap, caplen, pool, poollen)) == -1)
 			return -1;
+		rtype = (char)r;
+	} else {
+		if (term->_arealen != caplen) {
+			term->_arealen = caplen;
+			term->_area = realloc(term->_area, term->_arealen);
+			if (term->_area == NULL)
+				return -1;
+		}
+		memcpy(term->_area, cap, term->_arealen);
 	}
-	memcpy(term->_area, cap, term->_arealen);
 
 	cap = term->_area;
 	len = _ti_decode_16(&cap);
@@ -275,9 +443,9 @@ static int
 _ti_dbgetterm(TERMINAL *term, const char *path, const char *name, int flags)
 {
 	struct cdbr *db;
-	const void *data;
+	const void *data, *pool;
 	const uint8_t *data8;
-	size_t len, klen;
+	size_t len, klen, poollen;
 	int r;
 
 	r = snprintf(__ti_database, sizeof(__ti_database), "%s.cdb", path);
@@ -297,7 +465,8 @@ _ti_dbgetterm(TERMINAL *term, const char *path, const char *name, int flags)
 
 	r = 0;
 	klen = strlen(name) + 1;
-	if (cdbr_find(db, name, klen, &data, &len) == -1)
+	/* Key fingerprints reject most missing names without decoding. */
+	if (cdbr_find_verified(db, name, klen, &data, &len) == -1)
 		goto out;
 	data8 = data;
 	if (len == 0)
@@ -310,7 +479,18 @@ _ti_dbgetterm(TERMINAL *term, const char *path, const char *name, int flags)
 		data8 = data;
 	}
 
-	r = _ti_readterm(term, data, len, flags);
+	/* If the entry is pooled, find the string pool it uses. */
+	pool = NULL;
+	poollen = 0;
+	if (len != 0 && data8[0] == TERMINFO_RTYPE_POOLED) {
+		if (len < 1 + sizeof(uint32_t) ||
+		    cdbr_get(db, le32dec(data8 + 1), &pool, &poollen))
+			goto out;
+		if (poollen == 0 || *(const uint8_t *)pool != TERMINFO_POOL)
+			goto out;
+	}
+
+	r = _ti_readterm(term, data, len, pool, poollen, flags);
 	/* Ensure that this is the right terminfo description. */
         if (r == 1)
                 r = _ti_checkname(name, term->name, term->_alias);
@@ -405,7 +585,7 @@ _ti_findterm(TERMINAL *term, const char *name, int flags)
 			len = _ti_flatten(&f, tic);
 			if (len != -1) {
 				r = _ti_readterm(term, (char *)f, (size_t)len,
-				    flags);
+				    NULL, 0, flags);
 				free(f);
 			}
 		}
@@ -461,7 +641,8 @@ _ti_getterm(TERMINAL *term, const char *name, int flags)
 	for (i = 0; i < sizeof(compiled_terms) / sizeof(compiled_terms[0]); i++) {
 		t = &compiled_terms[i];
 		if (strcmp(name, t->name) == 0) {
-			r = _ti_readterm(term, t->cap, t->caplen, flags);
+			r = _ti_readterm(term, t->cap, t->caplen, NULL, 0,
+			    flags);
 			break;
 		}
 	}
@@ -49,6 +49,10 @@
  * Extends terminfo numbers upto 2147483647 by storing the value as a uint32_t.
  * This means that we exceed the current terminfo defined limits in every way.
  *
+ * Version 3 - types 4 and 5
+ * Capability strings are stored once in a string pool shared by every
+ * description in the file instead of in each description.
+ *
  * Type 1 capabilities are defined as:
  * header byte (always 1)
  * name
@@ -66,6 +70,17 @@
  * Type 3 extends Type 1 so that it can store terminfo numbers
  * as uint32_t. All other numerics are still stored as uint16_t.
  *
+ * Type 4 entries are pooled descriptions and defined as:
+ * header byte (always 4)
+ * 32bit id of the string pool in the file
+ * type of the description (1 or 3)
+ * followed by the description from the name onwards, except that each
+ * non empty string is stored as its length and a 32bit offset into the pool.
+ *
+ * Type 5 is the string pool:
+ * header byte (always 5)
+ * null terminated strings
+ *
  * The database itself is created using cdbw(3) and the numbers are
  * always stored as little endian.
  */
@@ -80,6 +95,8 @@
 #define TERMINFO_RTYPE_O1	1
 #define TERMINFO_ALIAS		2
 #define TERMINFO_RTYPE		3
+#define TERMINFO_RTYPE_POOLED	4
+#define TERMINFO_POOL		5
 
 /* , and | are the two print characters now allowed
  * in terminfo aliases or long descriptions.
@@ -169,8 +186,16 @@ typedef struct {
 	TBUF nums;
 	TBUF strs;
 	TBUF extras;
+	unsigned int warnings;	/* warnings issued while compiling it */
 } TIC;
 
+/* A string pool being built for type 4 descriptions */
+typedef struct {
+	TBUF buf;
+	struct tipool_slot *slots;
+	size_t nslots;
+} TIPOOL;
+
 #define _ti_numsize(tic) \
     ((tic)->rtype == TERMINFO_RTYPE_O1 ? sizeof(uint16_t) : sizeof(uint32_t))
 
@@ -184,7 +209,10 @@ size_t _ti_store_extra(TIC *, int, const char *, char, char, int,
     const char *, size_t, int);
 TIC *_ti_compile(char *, int);
 ssize_t _ti_flatten(uint8_t **, const TIC *);
+ssize_t _ti_flatten_pooled(uint8_t **, const TIC *, TIPOOL *, uint32_t);
+int _ti_loadpool(TIPOOL *, const void *, size_t);
 void _ti_freetic(TIC *);
+void _ti_freepool(TIPOOL *);
 
 int _ti_encode_buf_id_num(TBUF *, int, int, size_t);
 int _ti_encode_buf_id_count_str(TBUF *, int, const void *, size_t);
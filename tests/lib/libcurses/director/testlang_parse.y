@@ -120,6 +120,7 @@ static var_t *vars; 		/* Variables defined during the test. */
 static int	check_function_table(char *, const char *const[], int);
 static int	find_var_index(const char *);
 static void 	assign_arg(data_enum_t, void *);
+static void	assign_rets(data_enum_t, void *);
 static int	assign_var(const char *);
 void		init_parse_variables(int);
 static void	validate(int, void *);
@@ -148,6 +149,7 @@ static void	perform_delay(struct timespec *);
 static void	set_cchar(char *, void *);
 static void	set_wchar(char *);
 static wchar_t *add_to_vals(data_enum_t, void *);
+static void	yyerror(const char *);
 
 #define variants(fn) "" fn, "mv" fn, "w" fn, "mvw" fn
 static const char *const input_functions[] = {
@@ -177,6 +177,9 @@ struct command_def commands[] = {
 	{"init_color", cmd_init_color},
 	{"init_pair", cmd_init_pair},
 	{"initscr", cmd_initscr},
+	{"input_deadline", cmd_input_deadline},
+	{"input_feed", cmd_input_feed},
+	{"input_getch", cmd_input_getch},
 	{"intrflush", cmd_intrflush},
 	{"isendwin", cmd_isendwin},
 	{"is_linetouched", cmd_is_linetouched},
@@ -220,6 +223,8 @@ struct command_def commands[] = {
 	{"overlay", cmd_overlay},
 	{"overwrite", cmd_overwrite},
 	{"pair_content", cmd_pair_content},
+	{"paste_buffer", cmd_paste_buffer},
+	{"paste_mode", cmd_paste_mode},
 	{"pechochar", cmd_pechochar},
 	{"pnoutrefresh", cmd_pnoutrefresh},
 	{"prefresh", cmd_prefresh},
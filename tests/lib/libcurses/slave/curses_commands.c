@@ -1798,6 +1798,40 @@ cmd_initscr(int nargs, char **args)
 }
 
 
+void
+cmd_input_deadline(int nargs, char **args)
+{
+	ARGC(1);
+	ARG_WINDOW(win);
+
+	report_count(1);
+	report_int(input_deadline(win));
+}
+
+
+void
+cmd_input_feed(int nargs, char **args)
+{
+	ARGC(2);
+	ARG_STRING(buf);
+	ARG_INT(len);
+
+	report_count(1);
+	report_return(input_feed(buf, len));
+}
+
+
+void
+cmd_input_getch(int nargs, char **args)
+{
+	ARGC(1);
+	ARG_WINDOW(win);
+
+	report_count(1);
+	report_int(input_getch(win));
+}
+
+
 void
 cmd_intrflush(int nargs, char **args)
 {
@@ -2382,6 +2416,32 @@ cmd_pair_content(int nargs, char **args)
 }
 
 
+void
+cmd_paste_buffer(int nargs, char **args)
+{
+	ARGC(0);
+
+	const char *buf;
+	size_t len;
+
+	buf = paste_buffer(&len);
+	report_count(2);
+	report_int((int)len);
+	report_status(buf != NULL ? buf : "NULL");
+}
+
+
+void
+cmd_paste_mode(int nargs, char **args)
+{
+	ARGC(1);
+	ARG_INT(flag);
+
+	report_count(1);
+	report_return(paste_mode(flag));
+}
+
+
 void
 cmd_pechochar(int nargs, char **args)
 {
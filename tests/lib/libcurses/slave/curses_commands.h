@@ -178,6 +178,9 @@ void cmd_idlok(int, char **);
 void cmd_init_color(int, char **);
 void cmd_init_pair(int, char **);
 void cmd_initscr(int, char **);
+void cmd_input_deadline(int, char **);
+void cmd_input_feed(int, char **);
+void cmd_input_getch(int, char **);
 void cmd_intrflush(int, char **);
 void cmd_isendwin(int, char **);
 void cmd_is_linetouched(int, char **);
@@ -223,6 +226,8 @@ void cmd_notimeout(int, char **);
 void cmd_overlay(int, char **);
 void cmd_overwrite(int, char **);
 void cmd_pair_content(int, char **);
+void cmd_paste_buffer(int, char **);
+void cmd_paste_mode(int, char **);
 void cmd_pechochar(int, char **);
 void cmd_pnoutrefresh(int, char **);
 void cmd_prefresh(int, char **);
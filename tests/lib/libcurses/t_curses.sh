@@ -430,6 +430,26 @@ define_key_body()
 	h_run define_key
 }
 
+atf_test_case input_feed
+input_feed_head()
+{
+	atf_set "descr" "Check decoding fed input without reading the terminal"
+}
+input_feed_body()
+{
+	h_run input_feed
+}
+
+atf_test_case paste
+paste_head()
+{
+	atf_set "descr" "Check bracketed paste is returned as a single key"
+}
+paste_body()
+{
+	h_run paste
+}
+
 atf_test_case keyok
 keyok_head()
 {
@@ -1989,6 +2009,26 @@ getwin_body()
     h_run getwin
 }
 
+atf_test_case window_list
+window_list_head()
+{
+	atf_set "descr" "Check deleting and recreating windows and screens"
+}
+window_list_body()
+{
+	h_run window_list
+}
+
+atf_test_case wresize
+wresize_head()
+{
+	atf_set "descr" "Check resizing a window keeps its contents and cursor"
+}
+wresize_body()
+{
+	h_run wresize
+}
+
 ##########################################
 # curses background attribute manipulation routines
 ##########################################
@@ -2215,6 +2255,8 @@ atf_init_test_cases()
 	atf_add_test_case getch
 	#atf_add_test_case wgetch [test is missing]
 	atf_add_test_case define_key
+	atf_add_test_case input_feed
+	atf_add_test_case paste
 	atf_add_test_case keyok
 	atf_add_test_case getnstr
 	atf_add_test_case wgetnstr
@@ -2398,6 +2440,8 @@ atf_init_test_cases()
 	atf_add_test_case overlay
 	atf_add_test_case overwrite
 	atf_add_test_case getwin
+	atf_add_test_case window_list
+	atf_add_test_case wresize
 
 	# curses background attribute manipulation routines
 	atf_add_test_case background
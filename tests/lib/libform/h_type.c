@@ -0,0 +1,151 @@
+/*	$NetBSD$	*/
+
+/*
+ * Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Check the incremental validation of the builtin field types keeps up
+ * with characters appended after a successful validation.
+ *
+ *	h_type integer	validate a TYPE_INTEGER field, append to it and
+ *			check the validation state came along
+ *	h_type numeric	the same for a TYPE_NUMERIC field
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <curses.h>
+
+#include "internals.h"
+
+/*
+ * Type the characters of text into the field.
+ */
+static void
+type_text(FORM *form, const char *text)
+{
+
+	for (; *text != '\0'; text++)
+		if (form_driver(form, *text) != E_OK)
+			errx(1, "typing '%c' failed", *text);
+}
+
+/*
+ * Check the validation state of the field covers its contents, so the
+ * next validation will not scan the whole field again.
+ */
+static void
+check_stream(FIELD *field, const char *what)
+{
+
+	if (field->stream == NULL)
+		errx(1, "%s: no validation state", what);
+	if (field->stream_gen != field->gen)
+		errx(1, "%s: validation state at %u, field at %u", what,
+		    field->stream_gen, field->gen);
+	if (field->buf0_gen != field->gen)
+		errx(1, "%s: buffer 0 at %u, field at %u", what,
+		    field->buf0_gen, field->gen);
+}
+
+/*
+ * Validate the field holding first, append more to it and validate it
+ * again, the field must end up holding expect.
+ */
+static void
+appended(FIELD *field, const char *first, const char *more,
+    const char *expect)
+{
+	FIELD *fields[2];
+	FORM *form;
+
+	fields[0] = field;
+	fields[1] = NULL;
+	if ((form = new_form(fields)) == NULL)
+		err(1, "new_form");
+	if (post_form(form) != E_OK)
+		errx(1, "post_form failed");
+
+	type_text(form, first);
+	if (form_driver(form, REQ_VALIDATION) != E_OK)
+		errx(1, "\"%s\" did not validate", first);
+	check_stream(field, "after validation");
+
+	type_text(form, more);
+	check_stream(field, "after append");
+	if (form_driver(form, REQ_VALIDATION) != E_OK)
+		errx(1, "\"%s%s\" did not validate", first, more);
+	if (strcmp(field_buffer(field, 0), expect) != 0)
+		errx(1, "field holds \"%s\", expected \"%s\"",
+		    field_buffer(field, 0), expect);
+
+	unpost_form(form);
+	free_form(form);
+}
+
+static FIELD *
+make_field(void)
+{
+	FIELD *field;
+
+	if ((field = new_field(1, 20, 0, 0, 0, 0)) == NULL)
+		err(1, "new_field");
+	return field;
+}
+
+int
+main(int argc, char **argv)
+{
+	FILE *in, *out;
+	FIELD *field;
+
+	if (argc != 2)
+		errx(1, "usage: %s integer|numeric", argv[0]);
+
+	if ((in = fopen("/dev/null", "r")) == NULL ||
+	    (out = fopen("/dev/null", "w")) == NULL)
+		err(1, "/dev/null");
+	if (newterm("vt100", out, in) == NULL)
+		errx(1, "newterm failed");
+
+	field = make_field();
+	if (strcmp(argv[1], "integer") == 0) {
+		if (set_field_type(field, TYPE_INTEGER, 0, -100000L, 100000L)
+		    != E_OK)
+			errx(1, "set_field_type failed");
+		appended(field, "-12", "34", "-1234");
+	} else if (strcmp(argv[1], "numeric") == 0) {
+		if (set_field_type(field, TYPE_NUMERIC, 1, 0.0, 0.0) != E_OK)
+			errx(1, "set_field_type failed");
+		appended(field, "2.5", "0", "2.5");
+	} else
+		errx(1, "unknown test %s", argv[1]);
+
+	endwin();
+	return 0;
+}
@@ -0,0 +1,336 @@
+/*	$NetBSD$	*/
+
+/*
+ * Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Drive form_driver() on a multi-line field and check the rows and the
+ * cursor the word wrap leaves behind.
+ *
+ *	h_wrap newline	check the cursor after REQ_NEW_LINE rewraps the
+ *			paragraph above it
+ *	h_wrap fuzz	apply random edits to fields and print the rows and
+ *			the cursor after each one
+ *
+ * h_wrap_full is built from the same source with libform's wrap made to
+ * always run to the end of the paragraph, the fuzz output of the two must
+ * match.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <curses.h>
+
+#include "internals.h"
+
+#define FUZZ_SEEDS	1000
+#define FUZZ_EDITS	200
+
+#define PARA_ROWS	4000	/* rows of text in the long paragraph */
+#define PARA_EDITS	1000
+#define PARA_TOUCH_MAX	64	/* most rows an edit may change */
+
+static unsigned long fuzz_state;
+
+static unsigned int
+fuzz_random(unsigned int n)
+{
+
+	fuzz_state = fuzz_state * 1103515245 + 12345;
+	return (unsigned int)((fuzz_state >> 16) & 0x7fff) % n;
+}
+
+static FORM *
+make_form(FIELD **fields, int rows, int cols, int dynamic)
+{
+	FORM *form;
+
+	if ((fields[0] = new_field(rows, cols, 0, 0, 0, 0)) == NULL)
+		err(1, "new_field");
+	fields[1] = NULL;
+	if (dynamic)
+		field_opts_off(fields[0], O_STATIC);
+	if ((form = new_form(fields)) == NULL)
+		err(1, "new_form");
+	if (post_form(form) != E_OK)
+		errx(1, "post_form failed");
+	return form;
+}
+
+/*
+ * The field is not freed, free_field() walks the rows of a field as an
+ * array and they are a list.
+ */
+static void
+destroy_form(FORM *form)
+{
+
+	unpost_form(form);
+	free_form(form);
+}
+
+/*
+ * Print the rows of the field, one per line, for a failure report.
+ */
+static void
+dump_rows(const char *what, FIELD *field)
+{
+	_FORMI_FIELD_LINES *row;
+
+	fprintf(stderr, "%s:\n", what);
+	for (row = field->alines; row != NULL; row = row->next)
+		fprintf(stderr, "\t\"%s\"%s\n", row->string,
+		    row->hard_ret ? " (hard return)" : "");
+}
+
+static void
+newline(void)
+{
+	FIELD *fields[2];
+	FORM *form;
+	FIELD *field;
+	_FORMI_FIELD_LINES *row;
+	const char *p;
+	int y, x;
+
+	form = make_form(fields, 4, 10, 0);
+	field = fields[0];
+	for (p = "aaaaaa bbbbbbb"; *p != '\0'; p++)
+		form_driver(form, *p);
+	form_driver(form, REQ_LEFT_CHAR);
+	form_driver(form, REQ_LEFT_CHAR);
+	if (form_driver(form, REQ_NEW_LINE) != E_OK)
+		errx(1, "REQ_NEW_LINE failed");
+	form_driver(form, 'X');
+
+	row = field->alines->next->next;
+	if (row == NULL || strcmp(row->string, "Xbb") != 0) {
+		dump_rows("rows", field);
+		errx(1, "X is not at the start of row 2");
+	}
+	if (field->cursor_ypos != 2 || field->cursor_xpos != 1)
+		errx(1, "cursor at row %u col %u, expected row 2 col 1",
+		    field->cursor_ypos, field->cursor_xpos);
+	getyx(stdscr, y, x);
+	if (y != 2 || x != 1)
+		errx(1, "screen cursor at %d,%d, expected 2,1", y, x);
+
+	destroy_form(form);
+}
+
+static const int fuzz_requests[] = {
+	REQ_NEW_LINE, REQ_DEL_PREV, REQ_DEL_CHAR, REQ_LEFT_CHAR,
+	REQ_RIGHT_CHAR, REQ_UP_CHAR, REQ_DOWN_CHAR, REQ_BEG_LINE,
+	REQ_BEG_FIELD,
+};
+
+/*
+ * Deleting the last character of a row or the character before the
+ * first one, like REQ_END_LINE on an empty row, leaves the cursor
+ * positions of the field inconsistent and trips the assertion at the
+ * end of _formi_manipulate_field().  Only delete inside a row, that
+ * still makes the paragraph rewrap.
+ */
+static int
+fuzz_safe(FIELD *field, int c)
+{
+
+	if (c == REQ_DEL_CHAR)
+		return field->row_xpos + 1 < field->cur_line->length;
+	if (c == REQ_DEL_PREV)
+		return field->row_xpos > 0 &&
+		    field->row_xpos < field->cur_line->length;
+	return 1;
+}
+
+/*
+ * Print the rows and the cursor after every edit that was accepted so
+ * the output of h_wrap and h_wrap_full can be compared.
+ */
+static void
+fuzz(void)
+{
+	FIELD *fields[2];
+	FORM *form;
+	_FORMI_FIELD_LINES *row;
+	const char *chars = "abcdefghij   ";
+	unsigned int seed, edit, cols, i;
+	int c;
+
+	for (seed = 0; seed < FUZZ_SEEDS; seed++) {
+		fuzz_state = seed;
+		cols = 8 + fuzz_random(9);
+		form = make_form(fields, 4, cols, fuzz_random(2));
+
+		for (edit = 0; edit < FUZZ_EDITS; edit++) {
+			i = fuzz_random(3 + sizeof(fuzz_requests) /
+			    sizeof(fuzz_requests[0]));
+			if (i < 3)
+				c = chars[fuzz_random(strlen(chars))];
+			else
+				c = fuzz_requests[i - 3];
+			if (!fuzz_safe(fields[0], c))
+				continue;
+			if (form_driver(form, c) != E_OK)
+				continue;
+
+			printf("%u %u %u,%u:", seed, edit,
+			    fields[0]->cursor_ypos, fields[0]->cursor_xpos);
+			for (row = fields[0]->alines; row != NULL;
+			    row = row->next)
+				printf(" \"%s\"%s", row->string,
+				    row->hard_ret ? "$" : "");
+			printf("\n");
+		}
+
+		destroy_form(form);
+	}
+}
+
+/*
+ * Type a single paragraph of random words into a 40 column dynamic
+ * field until it holds at least rows rows, then put the cursor in the
+ * middle of it.
+ */
+static FORM *
+make_paragraph(FIELD **fields, unsigned int rows)
+{
+	FORM *form;
+	unsigned int i, len;
+
+	form = make_form(fields, 4, 40, 1);
+	fuzz_state = 1;
+	while (fields[0]->row_count < rows) {
+		len = 1 + fuzz_random(9);
+		for (i = 0; i < len; i++)
+			form_driver(form, 'a' + fuzz_random(26));
+		form_driver(form, ' ');
+	}
+
+	form_driver(form, REQ_BEG_FIELD);
+	for (i = 0; i < rows / 2; i++)
+		form_driver(form, REQ_DOWN_CHAR);
+	form_driver(form, REQ_END_LINE);
+	form_driver(form, REQ_LEFT_CHAR);
+	return form;
+}
+
+/*
+ * Each row records the field generation it last changed at, count the
+ * rows the last edit changed.
+ */
+static unsigned int
+rows_changed(FIELD *field)
+{
+	_FORMI_FIELD_LINES *row;
+	unsigned int count;
+
+	count = 0;
+	for (row = field->alines; row != NULL; row = row->next)
+		if (row->gen == field->gen)
+			count++;
+	return count;
+}
+
+static void
+paragraph(void)
+{
+	FIELD *fields[2];
+	FORM *form;
+	unsigned int edit, changed;
+
+	form = make_paragraph(fields, PARA_ROWS);
+	for (edit = 0; edit < PARA_EDITS; edit++) {
+		if (form_driver(form, (edit % 6 == 5) ? ' ' : 'x') != E_OK)
+			errx(1, "insert %u failed", edit);
+		changed = rows_changed(fields[0]);
+		if (changed > PARA_TOUCH_MAX)
+			errx(1, "insert %u changed %u of %u rows", edit,
+			    changed, fields[0]->row_count);
+	}
+
+	destroy_form(form);
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench(void)
+{
+	FIELD *fields[2];
+	FORM *form;
+	unsigned int rows, edit;
+	double start;
+
+	for (rows = 1000; rows <= 16000; rows *= 2) {
+		form = make_paragraph(fields, rows);
+		start = now();
+		for (edit = 0; edit < PARA_EDITS; edit++)
+			form_driver(form, (edit % 6 == 5) ? ' ' : 'x');
+		printf("%5u rows: %.1f us per insert\n", fields[0]->row_count,
+		    (now() - start) * 1e6 / PARA_EDITS);
+		destroy_form(form);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	FILE *in, *out;
+
+	if (argc != 2)
+		errx(1, "usage: %s newline|fuzz|paragraph|bench", argv[0]);
+
+	if ((in = fopen("/dev/null", "r")) == NULL ||
+	    (out = fopen("/dev/null", "w")) == NULL)
+		err(1, "/dev/null");
+	if (newterm("vt100", out, in) == NULL)
+		errx(1, "newterm failed");
+
+	if (strcmp(argv[1], "newline") == 0)
+		newline();
+	else if (strcmp(argv[1], "fuzz") == 0)
+		fuzz();
+	else if (strcmp(argv[1], "paragraph") == 0)
+		paragraph();
+	else if (strcmp(argv[1], "bench") == 0)
+		bench();
+	else
+		errx(1, "unknown test %s", argv[1]);
+
+	endwin();
+	return 0;
+}
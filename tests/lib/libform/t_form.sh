@@ -0,0 +1,74 @@
+h_wrap()
+{
+	atf_check -s exit:0 $(atf_get_srcdir)/h_wrap $1
+}
+
+h_type()
+{
+	atf_check -s exit:0 $(atf_get_srcdir)/h_type $1
+}
+
+atf_test_case wrap_newline
+wrap_newline_head()
+{
+	atf_set "descr" "Checks the cursor row after REQ_NEW_LINE rewraps" \
+	    "the paragraph above"
+}
+wrap_newline_body()
+{
+	h_wrap newline
+}
+
+atf_test_case wrap_fuzz
+wrap_fuzz_head()
+{
+	atf_set "descr" "Checks that stopping a rewrap early gives the same" \
+	    "rows as a rewrap to the end of the paragraph"
+}
+wrap_fuzz_body()
+{
+	atf_check -s exit:0 -o save:expout $(atf_get_srcdir)/h_wrap_full fuzz
+	atf_check -s exit:0 -o file:expout $(atf_get_srcdir)/h_wrap fuzz
+}
+
+atf_test_case wrap_paragraph
+wrap_paragraph_head()
+{
+	atf_set "descr" "Checks that an edit in the middle of a paragraph of" \
+	    "thousands of rows only rewraps the rows around it"
+}
+wrap_paragraph_body()
+{
+	h_wrap paragraph
+}
+
+atf_test_case type_integer
+type_integer_head()
+{
+	atf_set "descr" "Checks a validated TYPE_INTEGER field keeps its" \
+	    "validation state as characters are appended"
+}
+type_integer_body()
+{
+	h_type integer
+}
+
+atf_test_case type_numeric
+type_numeric_head()
+{
+	atf_set "descr" "Checks a validated TYPE_NUMERIC field keeps its" \
+	    "validation state as characters are appended"
+}
+type_numeric_body()
+{
+	h_type numeric
+}
+
+atf_init_test_cases()
+{
+	atf_add_test_case wrap_newline
+	atf_add_test_case wrap_fuzz
+	atf_add_test_case wrap_paragraph
+	atf_add_test_case type_integer
+	atf_add_test_case type_numeric
+}
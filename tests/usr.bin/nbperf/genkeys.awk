@@ -0,0 +1,7 @@
+# Keys of all lengths up to 32 bytes, so that mi_vector_hash() handles
+# every tail length, and enough of them for 16 bit tables.
+BEGIN {
+	chars = "abcdefghijklmnopqrstuvwxyz0123456789_-ABCDEF"
+	for (i = 0; i < 3000; ++i)
+		printf "%s%d\n", substr(chars, 1 + i % 11, i % 29), i
+}
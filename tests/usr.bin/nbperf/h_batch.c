@@ -0,0 +1,152 @@
+/*	$NetBSD$	*/
+
+/*
+ * Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Check that the batch functions written by nbperf -b agree with the
+ * scalar hash functions for every key and for every way of splitting
+ * the key list into batches.
+ */
+
+#include <err.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __NetBSD__
+#include <strings.h>
+#else
+#define	popcount64(x)	((uint32_t)__builtin_popcountll(x))
+#endif
+#include <mi_vector_hash.h>
+
+#include "hash_chm.c"
+#include "hash_chm3.c"
+#include "hash_bpz.c"
+#include "hash_bpz_packed.c"
+
+static const struct {
+	const char *name;
+	uint32_t (*hash)(const void *restrict, size_t);
+	void (*batch)(const void *const *restrict, const size_t *restrict,
+	    uint32_t *restrict, size_t);
+} hashes[] = {
+	{ "chm", hash_chm, hash_chm_batch },
+	{ "chm3", hash_chm3, hash_chm3_batch },
+	{ "bpz", hash_bpz, hash_bpz_batch },
+	{ "bpz_packed", hash_bpz_packed, hash_bpz_packed_batch },
+};
+
+int
+main(int argc, char **argv)
+{
+	FILE *input;
+	char *line;
+	size_t line_allocated, curalloc, n, i, j, step;
+	ssize_t line_len;
+	const void **keys;
+	size_t *keylens;
+	uint32_t *expected, *out;
+	unsigned char *seen;
+	size_t h;
+
+	if (argc != 3)
+		errx(1, "usage: %s algorithm keys", argv[0]);
+	for (h = 0; h < sizeof(hashes) / sizeof(hashes[0]); ++h) {
+		if (strcmp(hashes[h].name, argv[1]) == 0)
+			break;
+	}
+	if (h == sizeof(hashes) / sizeof(hashes[0]))
+		errx(1, "unknown algorithm: %s", argv[1]);
+	if ((input = fopen(argv[2], "r")) == NULL)
+		err(1, "can't open %s", argv[2]);
+
+	keys = NULL;
+	keylens = NULL;
+	n = curalloc = 0;
+	line = NULL;
+	line_allocated = 0;
+	while ((line_len = getline(&line, &line_allocated, input)) != -1) {
+		if (line_len && line[line_len - 1] == '\n')
+			--line_len;
+		if (n == curalloc) {
+			curalloc = curalloc ? 2 * curalloc : 256;
+			keys = realloc(keys, curalloc * sizeof(*keys));
+			keylens = realloc(keylens, curalloc * sizeof(*keylens));
+			if (keys == NULL || keylens == NULL)
+				err(1, "realloc failed");
+		}
+		if ((keys[n] = strndup(line, line_len)) == NULL)
+			err(1, "malloc failed");
+		keylens[n] = line_len;
+		++n;
+	}
+	free(line);
+	fclose(input);
+
+	expected = calloc(n + 1, sizeof(*expected));
+	out = calloc(n + 1, sizeof(*out));
+	seen = calloc(n + 1, 1);
+	if (expected == NULL || out == NULL || seen == NULL)
+		err(1, "malloc failed");
+
+	/* The scalar function must be a minimal perfect hash. */
+	for (i = 0; i < n; ++i) {
+		expected[i] = (*hashes[h].hash)(keys[i], keylens[i]);
+		if (expected[i] >= n || seen[expected[i]]++)
+			errx(1, "%s: not a perfect hash for key %zu",
+			    argv[1], i);
+	}
+
+	/*
+	 * Feed the keys in batches of every size up to twice the block
+	 * size of the batch function and as a whole, so that both full
+	 * and partial blocks are covered.
+	 */
+	for (step = 1; step <= n; step = step < 17 ? step + 1 : n) {
+		memset(out, 0xff, (n + 1) * sizeof(*out));
+		for (i = 0; i < n; i += step) {
+			(*hashes[h].batch)(keys + i, keylens + i, out + i,
+			    n - i < step ? n - i : step);
+		}
+		for (j = 0; j < n; ++j) {
+			if (out[j] != expected[j])
+				errx(1, "%s: batches of %zu: key %zu hashes to "
+				    "%" PRIu32 " instead of %" PRIu32, argv[1],
+				    step, j, out[j], expected[j]);
+		}
+		if (out[n] != UINT32_MAX)
+			errx(1, "%s: batches of %zu: wrote past the end",
+			    argv[1], step);
+		if (step == n)
+			break;
+	}
+	(*hashes[h].batch)(keys, keylens, out, 0);
+
+	printf("%zu keys\n", n);
+	return 0;
+}
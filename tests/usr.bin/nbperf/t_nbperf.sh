@@ -0,0 +1,54 @@
+h_batch()
+{
+	atf_check -s exit:0 -o ignore \
+	    $(atf_get_srcdir)/h_batch $1 $(atf_get_srcdir)/keys
+}
+
+atf_test_case batch_chm
+batch_chm_head()
+{
+	atf_set "descr" "Checks the chm batch function against the scalar one"
+}
+batch_chm_body()
+{
+	h_batch chm
+}
+
+atf_test_case batch_chm3
+batch_chm3_head()
+{
+	atf_set "descr" "Checks the chm3 batch function against the scalar one"
+}
+batch_chm3_body()
+{
+	h_batch chm3
+}
+
+atf_test_case batch_bpz
+batch_bpz_head()
+{
+	atf_set "descr" "Checks the bpz batch function against the scalar one"
+}
+batch_bpz_body()
+{
+	h_batch bpz
+}
+
+atf_test_case batch_bpz_packed
+batch_bpz_packed_head()
+{
+	atf_set "descr" "Checks the packed bpz batch function against the" \
+	    "scalar one"
+}
+batch_bpz_packed_body()
+{
+	h_batch bpz_packed
+}
+
+atf_init_test_cases()
+{
+	atf_add_test_case batch_chm
+	atf_add_test_case batch_chm3
+	atf_add_test_case batch_bpz
+	atf_add_test_case batch_bpz_packed
+}
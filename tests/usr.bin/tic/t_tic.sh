@@ -0,0 +1,23 @@
+h_jobs()
+{
+	atf_check -s exit:0 -e file:$(atf_get_srcdir)/warn.err \
+	    tic -j $1 -o jobs$1.cdb $(atf_get_srcdir)/warn.terminfo
+}
+
+atf_test_case warn_jobs
+warn_jobs_head()
+{
+	atf_set "descr" "Checks that tic gives the same warnings, in the same" \
+	    "order, compiling on one thread and on several"
+}
+warn_jobs_body()
+{
+	h_jobs 1
+	h_jobs 4
+	atf_check -s exit:0 cmp jobs1.cdb jobs4.cdb
+}
+
+atf_init_test_cases()
+{
+	atf_add_test_case warn_jobs
+}
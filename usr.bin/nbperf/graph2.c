@@ -40,16 +40,45 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef NBPERF_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 #include "nbperf.h"
 #include "graph2.h"
 
+/*
+ * The buffers of a freed graph are kept for the next one, as a failed
+ * seed is retried with a graph of the same size. They are fully written
+ * by SIZED2(_hash) and SIZED2(_output_order), so no clearing is needed.
+ */
+static struct SIZED(graph) spare_graph;
+
 void
 SIZED2(_setup)(struct SIZED(graph) *graph, uint32_t v, uint32_t e)
 {
 	graph->v = v;
 	graph->e = e;
 
+	if (spare_graph.verts != NULL && spare_graph.v == v &&
+	    spare_graph.e == e) {
+		graph->verts = spare_graph.verts;
+		graph->edges = spare_graph.edges;
+		graph->output_order = spare_graph.output_order;
+		spare_graph.verts = NULL;
+		spare_graph.edges = NULL;
+		spare_graph.output_order = NULL;
+		return;
+	}
+
+	free(spare_graph.verts);
+	free(spare_graph.edges);
+	free(spare_graph.output_order);
+	spare_graph.verts = NULL;
+	spare_graph.edges = NULL;
+	spare_graph.output_order = NULL;
+
 	graph->verts = calloc(sizeof(*graph->verts), v);
 	graph->edges = calloc(sizeof(*graph->edges), e);
 	graph->output_order = calloc(sizeof(uint32_t), e);
@@ -62,68 +91,66 @@ SIZED2(_setup)(struct SIZED(graph) *graph, uint32_t v, uint32_t e)
 void
 SIZED2(_free)(struct SIZED(graph) *graph)
 {
-	free(graph->verts);
-	free(graph->edges);
-	free(graph->output_order);
+	free(spare_graph.verts);
+	free(spare_graph.edges);
+	free(spare_graph.output_order);
+
+	spare_graph.verts = graph->verts;
+	spare_graph.edges = graph->edges;
+	spare_graph.output_order = graph->output_order;
+	spare_graph.v = graph->v;
+	spare_graph.e = graph->e;
 
 	graph->verts = NULL;
 	graph->edges = NULL;
 	graph->output_order = NULL;
 }
 
-static struct nbperf *sorting_nbperf;
-static struct SIZED(graph) *sorting_graph;
-static int sorting_found;
-
-static int sorting_cmp(const void *a_, const void *b_)
-{
-	const uint32_t *a = a_, *b = b_;
-	int i;
-	const struct SIZED(edge) *ea = &sorting_graph->edges[*a],
-	    *eb = &sorting_graph->edges[*b];
-	for (i = 0; i < GRAPH_SIZE; ++i) {
-		if (ea->vertices[i] < eb->vertices[i])
-			return -1;
-		if (ea->vertices[i] > eb->vertices[i])
-			return 1;
-	}
-	if (sorting_nbperf->keylens[*a] < sorting_nbperf->keylens[*b])
-		return -1;
-	if (sorting_nbperf->keylens[*a] > sorting_nbperf->keylens[*b])
-		return 1;
-	i = memcmp(sorting_nbperf->keys[*a], sorting_nbperf->keys[*b],
-	    sorting_nbperf->keylens[*a]);
-	if (i == 0)
-		sorting_found = 1;
-	return i;
-}
-
+/*
+ * Identical keys hash to identical edges, so duplicates are found with
+ * an open addressing table indexed by the vertices of each edge. Only
+ * keys on the same edge are compared.
+ */
 static int
 SIZED2(_check_duplicates)(struct nbperf *nbperf, struct SIZED(graph) *graph)
 {
-	size_t i;
-	uint32_t *key_index = calloc(sizeof(*key_index), graph->e);
-
-	if (key_index == NULL)
+	const struct SIZED(edge) *e, *e2;
+	uint32_t *table, mask, slot, i, j;
+	size_t size;
+
+	for (size = 16; size < 2 * (size_t)graph->e; size += size)
+		continue;
+	table = calloc(sizeof(*table), size);
+	if (table == NULL)
 		err(1, "malloc failed");
-	for (i = 0; i < graph->e; ++i)
-		key_index[i] = i;
-
-	sorting_nbperf = nbperf;
-	sorting_graph = graph;
-	sorting_found = 0;
-	qsort(key_index, graph->e, sizeof(*key_index), sorting_cmp);
-	if (sorting_found)
-		goto found_dups;
-	/*
-	 * Any duplicate must have been found as part of the qsort,
-	 * as it can't sort consecutive elements in the output without
-	 * comparing them at least once.
-	 */
-
-	free(key_index);
+	mask = (uint32_t)(size - 1);
+
+	for (i = 0; i < graph->e; ++i) {
+		e = graph->edges + i;
+		slot = 0;
+		for (j = 0; j < GRAPH_SIZE; ++j)
+			slot = (slot ^ e->vertices[j]) * 0x9e3779b1U;
+		slot = (slot ^ (slot >> 16)) & mask;
+		for (; table[slot] != 0; slot = (slot + 1) & mask) {
+			e2 = graph->edges + table[slot] - 1;
+			for (j = 0; j < GRAPH_SIZE; ++j) {
+				if (e->vertices[j] != e2->vertices[j])
+					break;
+			}
+			if (j < GRAPH_SIZE ||
+			    nbperf->keylens[i] != nbperf->keylens[table[slot] - 1])
+				continue;
+			if (memcmp(nbperf->keys[i], nbperf->keys[table[slot] - 1],
+			    nbperf->keylens[i]) == 0)
+				goto found_dups;
+		}
+		table[slot] = i + 1;
+	}
+
+	free(table);
 	return 0;
  found_dups:
+	free(table);
 	nbperf->has_duplicates = 1;
 	return -1;
 }
@@ -169,26 +196,21 @@ SIZED2(_remove_vertex)(struct SIZED(graph) *graph, uint32_t vertex)
 	}
 }
 
-int
-SIZED2(_hash)(struct nbperf *nbperf, struct SIZED(graph) *graph)
+/*
+ * Compute the edges start to end, recording the kind of fudging needed
+ * in *hash_fudge. Fail on the first degenerate edge if fudging is not
+ * allowed.
+ */
+static int
+SIZED2(_hash_edges)(struct nbperf *nbperf, struct SIZED(graph) *graph,
+    uint32_t start, uint32_t end, int *hash_fudge)
 {
 	struct SIZED(edge) *e;
 	uint32_t hashes[NBPERF_MAX_HASH_SIZE];
-	size_t i, j;
+	uint32_t i;
+	size_t j;
 
-#if GRAPH_SIZE == 2
-	if (nbperf->allow_hash_fudging && (graph->v & 1) != 0)
-		errx(1, "vertex count must have lowest bit clear");
-#else
-	if (nbperf->allow_hash_fudging && (graph->v & 3) != 0)
-		errx(1, "vertex count must have lowest 2 bits clear");
-#endif
-
-
-	memset(graph->verts, 0, sizeof(*graph->verts) * graph->v);
-	graph->hash_fudge = 0;
-
-	for (i = 0; i < graph->e; ++i) {
+	for (i = start; i < end; ++i) {
 		(*nbperf->compute_hash)(nbperf,
 		    nbperf->keys[i], nbperf->keylens[i], hashes);
 		e = graph->edges + i;
@@ -198,14 +220,14 @@ SIZED2(_hash)(struct nbperf *nbperf, struct SIZED(graph) *graph)
 				if (!nbperf->allow_hash_fudging)
 					return -1;
 				e->vertices[1] ^= 1; /* toogle bit to differ */
-				graph->hash_fudge |= 1;
+				*hash_fudge |= 1;
 			}
 #if GRAPH_SIZE == 3
 			if (j == 2 && (e->vertices[0] == e->vertices[2] ||
 			    e->vertices[1] == e->vertices[2])) {
 				if (!nbperf->allow_hash_fudging)
 					return -1;
-				graph->hash_fudge |= 2;
+				*hash_fudge |= 2;
 				e->vertices[2] ^= 1;
 				e->vertices[2] ^= 2 * (e->vertices[0] == e->vertices[2] ||
 				    e->vertices[1] == e->vertices[2]);
@@ -213,7 +235,138 @@ SIZED2(_hash)(struct nbperf *nbperf, struct SIZED(graph) *graph)
 #endif
 		}
 	}
+	return 0;
+}
+
+#ifdef NBPERF_THREADS
+/*
+ * Large key sets are hashed in slices on several threads. Every edge
+ * only depends on its own key, so the graph is the same as when hashing
+ * in order. Each slice checks every SLICE_CHUNK keys whether another has
+ * found a degenerate edge.
+ */
+#define	THREAD_KEYS	65536
+#define	MAX_THREADS	16
+#define	SLICE_CHUNK	4096
+
+struct hash_shared {
+	struct nbperf *nbperf;
+	struct SIZED(graph) *graph;
+	pthread_mutex_t lock;
+	int failed;
+};
+
+struct hash_slice {
+	pthread_t thread;
+	int started;
+	struct hash_shared *shared;
+	uint32_t start, end;
+	int hash_fudge;
+	int rv;
+};
+
+static void *
+SIZED2(_hash_slice)(void *arg)
+{
+	struct hash_slice *slice = arg;
+	struct hash_shared *shared = slice->shared;
+	uint32_t i, end;
+	int failed;
+
+	for (i = slice->start; i < slice->end; i = end) {
+		pthread_mutex_lock(&shared->lock);
+		failed = shared->failed;
+		pthread_mutex_unlock(&shared->lock);
+		if (failed)
+			break;
+		end = slice->end - i > SLICE_CHUNK ?
+		    i + SLICE_CHUNK : slice->end;
+		if (SIZED2(_hash_edges)(shared->nbperf, shared->graph, i, end,
+		    &slice->hash_fudge)) {
+			pthread_mutex_lock(&shared->lock);
+			shared->failed = 1;
+			pthread_mutex_unlock(&shared->lock);
+			break;
+		}
+	}
+	slice->rv = i < slice->end ? -1 : 0;
+	return NULL;
+}
+
+static int
+SIZED2(_hash_keys)(struct nbperf *nbperf, struct SIZED(graph) *graph)
+{
+	struct hash_shared shared;
+	struct hash_slice slices[MAX_THREADS];
+	long ncpu;
+	uint32_t n, i, step;
+	int rv;
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	n = graph->e / THREAD_KEYS;
+	if (ncpu > 0 && n > (uint32_t)ncpu)
+		n = (uint32_t)ncpu;
+	if (n > MAX_THREADS)
+		n = MAX_THREADS;
+	if (n <= 1 || pthread_mutex_init(&shared.lock, NULL) != 0)
+		return SIZED2(_hash_edges)(nbperf, graph, 0, graph->e,
+		    &graph->hash_fudge);
+
+	shared.nbperf = nbperf;
+	shared.graph = graph;
+	shared.failed = 0;
+	step = graph->e / n;
+	for (i = 0; i < n; ++i) {
+		slices[i].shared = &shared;
+		slices[i].start = i * step;
+		slices[i].end = i == n - 1 ? graph->e : (i + 1) * step;
+		slices[i].hash_fudge = 0;
+		slices[i].started = i != 0 && pthread_create(&slices[i].thread,
+		    NULL, SIZED2(_hash_slice), &slices[i]) == 0;
+	}
+	/* Hash here the slices that no thread was started for. */
+	rv = 0;
+	for (i = 0; i < n; ++i) {
+		if (!slices[i].started)
+			SIZED2(_hash_slice)(&slices[i]);
+	}
+	for (i = 0; i < n; ++i) {
+		if (slices[i].started)
+			pthread_join(slices[i].thread, NULL);
+		if (slices[i].rv != 0)
+			rv = -1;
+		graph->hash_fudge |= slices[i].hash_fudge;
+	}
+	pthread_mutex_destroy(&shared.lock);
+	return rv;
+}
+#else
+static int
+SIZED2(_hash_keys)(struct nbperf *nbperf, struct SIZED(graph) *graph)
+{
+	return SIZED2(_hash_edges)(nbperf, graph, 0, graph->e,
+	    &graph->hash_fudge);
+}
+#endif
+
+int
+SIZED2(_hash)(struct nbperf *nbperf, struct SIZED(graph) *graph)
+{
+	size_t i;
+
+#if GRAPH_SIZE == 2
+	if (nbperf->allow_hash_fudging && (graph->v & 1) != 0)
+		errx(1, "vertex count must have lowest bit clear");
+#else
+	if (nbperf->allow_hash_fudging && (graph->v & 3) != 0)
+		errx(1, "vertex count must have lowest 2 bits clear");
+#endif
 
+	graph->hash_fudge = 0;
+	if (SIZED2(_hash_keys)(nbperf, graph))
+		return -1;
+
+	memset(graph->verts, 0, sizeof(*graph->verts) * graph->v);
 	for (i = 0; i < graph->e; ++i)
 		SIZED2(_add_edge)(graph, i);
 
@@ -131,23 +131,17 @@ assign_nodes(struct state *state)
 	}
 }
 
+/*
+ * By default, g is written as two bit planes: g1 holds the low and g2
+ * the high bit of each vertex.
+ */
 static void
-print_hash(struct nbperf *nbperf, struct state *state)
+print_g_planes(struct nbperf *nbperf, struct state *state)
 {
 	uint64_t sum;
 	size_t i;
 
-	fprintf(nbperf->output, "#include <stdlib.h>\n");
-
-	fprintf(nbperf->output, "%suint32_t\n",
-	    nbperf->static_hash ? "static " : "");
-	fprintf(nbperf->output,
-	    "%s(const void *restrict key, size_t keylen)\n",
-	    nbperf->hash_name);
-	fprintf(nbperf->output, "{\n");
-
-	fprintf(nbperf->output,
-	    "\tstatic const uint64_t g1[%" PRId32 "] = {\n",
+	print_table_start(nbperf, "uint64_t", "g1",
 	    (state->graph.v + 63) / 64);
 	sum = 0;
 	for (i = 0; i < state->graph.v; ++i) {
@@ -166,10 +160,9 @@ print_hash(struct nbperf *nbperf, struct state *state)
 		    sum,
 		    (i / 64 % 2 == 1 ? "\n" : ""));
 	}
-	fprintf(nbperf->output, "%s\t};\n", (i % 2 ? "\n" : ""));
+	print_table_end(nbperf, i % 2);
 
-	fprintf(nbperf->output,
-	    "\tstatic const uint64_t g2[%" PRId32 "] = {\n",
+	print_table_start(nbperf, "uint64_t", "g2",
 	    (state->graph.v + 63) / 64);
 	sum = 0;
 	for (i = 0; i < state->graph.v; ++i) {
@@ -188,70 +181,206 @@ print_hash(struct nbperf *nbperf, struct state *state)
 		    sum,
 		    (i / 64 % 2 == 1 ? "\n" : ""));
 	}
-	fprintf(nbperf->output, "%s\t};\n", (i % 2 ? "\n" : ""));
+	print_table_end(nbperf, i % 2);
+}
 
-	fprintf(nbperf->output,
-	    "\tstatic const uint32_t holes64k[%" PRId32 "] = {\n",
+/*
+ * With -P, the two bits of each vertex are stored next to each other,
+ * 32 vertices per word, so that each of the three vertices of a key
+ * costs a single load.
+ */
+static void
+print_g_packed(struct nbperf *nbperf, struct state *state)
+{
+	uint64_t sum;
+	size_t i;
+
+	print_table_start(nbperf, "uint64_t", "g",
+	    (state->graph.v + 31) / 32);
+	sum = 0;
+	for (i = 0; i < state->graph.v; ++i) {
+		sum |= ((uint64_t)state->g[i] & 3) << (2 * (i & 31));
+		if (i % 32 == 31) {
+			fprintf(nbperf->output, "%s0x%016" PRIx64 "ULL,%s",
+			    (i / 32 % 2 == 0 ? "\t    " : " "),
+			    sum,
+			    (i / 32 % 2 == 1 ? "\n" : ""));
+			sum = 0;
+		}
+	}
+	if (i % 32 != 0) {
+		fprintf(nbperf->output, "%s0x%016" PRIx64 "ULL,%s",
+		    (i / 32 % 2 == 0 ? "\t    " : " "),
+		    sum,
+		    (i / 32 % 2 == 1 ? "\n" : ""));
+		i += 32;
+	}
+	print_table_end(nbperf, i / 32 % 2);
+}
+
+static const char *lookup_planes[] = {
+	"idx = 9 + ((g1[h[0] >> 6] >> (h[0] & 63)) &1)",
+	"      + ((g1[h[1] >> 6] >> (h[1] & 63)) & 1)",
+	"      + ((g1[h[2] >> 6] >> (h[2] & 63)) & 1)",
+	"      - ((g2[h[0] >> 6] >> (h[0] & 63)) & 1)",
+	"      - ((g2[h[1] >> 6] >> (h[1] & 63)) & 1)",
+	"      - ((g2[h[2] >> 6] >> (h[2] & 63)) & 1);",
+	"idx = h[idx % 3];",
+	"idx2 = idx - holes64[idx >> 6] - holes64k[idx >> 16];",
+	"idx2 -= popcount64(g1[idx >> 6] & g2[idx >> 6]",
+	"                   & (((uint64_t)1 << (idx & 63)) - 1));",
+	NULL
+};
+
+/*
+ * A vertex value of 3 marks a hole, which counts as 0 for the sum.
+ * The rank tables count the holes per 64 vertices, i.e. per pair of
+ * words, which share a cache line. The holes of the pair before the
+ * vertex are counted with a single popcount by moving those of the
+ * second word to the odd bits. Masks are used instead of a branch on
+ * the word, which could not be predicted.
+ */
+static const char *lookup_packed[] = {
+	"idx = (((g[h[0] >> 5] >> ((h[0] & 31) << 1)) & 3)",
+	"      + ((g[h[1] >> 5] >> ((h[1] & 31) << 1)) & 3)",
+	"      + ((g[h[2] >> 5] >> ((h[2] & 31) << 1)) & 3));",
+	"idx = h[idx % 3];",
+	"idx2 = idx - holes64[idx >> 6] - holes64k[idx >> 16];",
+	"w = g[idx >> 5];",
+	"w2 = g[(idx >> 5) & ~1U];",
+	"m = ((uint64_t)1 << ((idx & 31) << 1)) - 1;",
+	"odd = -(uint64_t)((idx >> 5) & 1);",
+	"idx2 -= popcount64((w2 & (w2 >> 1) & 0x5555555555555555ULL",
+	"                    & (m | odd))",
+	"                   | ((w & (w >> 1) & 0x5555555555555555ULL",
+	"                    & m & odd) << 1));",
+	NULL
+};
+
+static void
+print_reduce(struct nbperf *nbperf, struct state *state, const char *indent)
+{
+	fprintf(nbperf->output, "%sh[0] = h[0] %% %" PRIu32 ";\n",
+	    indent, state->graph.v);
+	fprintf(nbperf->output, "%sh[1] = h[1] %% %" PRIu32 ";\n",
+	    indent, state->graph.v);
+	fprintf(nbperf->output, "%sh[2] = h[2] %% %" PRIu32 ";\n",
+	    indent, state->graph.v);
+
+	if (state->graph.hash_fudge & 1)
+		fprintf(nbperf->output, "%sh[1] ^= (h[0] == h[1]);\n", indent);
+
+	if (state->graph.hash_fudge & 2) {
+		fprintf(nbperf->output,
+		    "%sh[2] ^= (h[0] == h[2] || h[1] == h[2]);\n", indent);
+		fprintf(nbperf->output,
+		    "%sh[2] ^= 2 * (h[0] == h[2] || h[1] == h[2]);\n", indent);
+	}
+}
+
+static void
+print_lookup(struct nbperf *nbperf, const char *indent, const char *result)
+{
+	const char **line;
+
+	line = nbperf->packed_g ? lookup_packed : lookup_planes;
+	for (; *line != NULL; ++line)
+		fprintf(nbperf->output, "%s%s\n", indent, *line);
+	fprintf(nbperf->output, "%s%sidx2;\n", indent, result);
+}
+
+static void
+print_locals(struct nbperf *nbperf)
+{
+	if (nbperf->packed_g)
+		fprintf(nbperf->output, "\tuint64_t w, w2, m, odd;\n");
+	fprintf(nbperf->output, "\tuint32_t idx, idx2;\n");
+}
+
+static void
+print_aliases(struct nbperf *nbperf)
+{
+	if (nbperf->packed_g)
+		print_table_alias(nbperf, "uint64_t", "g");
+	else {
+		print_table_alias(nbperf, "uint64_t", "g1");
+		print_table_alias(nbperf, "uint64_t", "g2");
+	}
+	print_table_alias(nbperf, "uint32_t", "holes64k");
+	print_table_alias(nbperf, "uint16_t", "holes64");
+}
+
+static void
+print_hash(struct nbperf *nbperf, struct state *state)
+{
+	size_t i;
+
+	fprintf(nbperf->output, "#include <stdlib.h>\n");
+
+	if (nbperf->batch)
+		fprintf(nbperf->output, "\n");
+	else {
+		fprintf(nbperf->output, "%suint32_t\n",
+		    nbperf->static_hash ? "static " : "");
+		fprintf(nbperf->output,
+		    "%s(const void *restrict key, size_t keylen)\n",
+		    nbperf->hash_name);
+		fprintf(nbperf->output, "{\n");
+	}
+
+	if (nbperf->packed_g)
+		print_g_packed(nbperf, state);
+	else
+		print_g_planes(nbperf, state);
+
+	print_table_start(nbperf, "uint32_t", "holes64k",
 	    (state->graph.v + 65535) / 65536);
 	for (i = 0; i < state->graph.v; i += 65536)
 		fprintf(nbperf->output, "%s0x%08" PRIx32 ",%s",
 		    (i / 65536 % 4 == 0 ? "\t    " : " "),
 		    state->holes64k[i >> 16],
 		    (i / 65536 % 4 == 3 ? "\n" : ""));
-	fprintf(nbperf->output, "%s\t};\n", (i / 65536 % 4 ? "\n" : ""));
+	print_table_end(nbperf, i / 65536 % 4);
 
-	fprintf(nbperf->output,
-	    "\tstatic const uint16_t holes64[%" PRId32 "] = {\n",
+	print_table_start(nbperf, "uint16_t", "holes64",
 	    (state->graph.v + 63) / 64);
 	for (i = 0; i < state->graph.v; i += 64)
 		fprintf(nbperf->output, "%s0x%04" PRIx32 ",%s",
 		    (i / 64 % 4 == 0 ? "\t    " : " "),
 		    state->holes64[i >> 6],
 		    (i / 64 % 4 == 3 ? "\n" : ""));
-	fprintf(nbperf->output, "%s\t};\n", (i / 64 % 4 ? "\n" : "")); 
+	print_table_end(nbperf, i / 64 % 4);
 
-	fprintf(nbperf->output, "\tuint64_t m;\n");
-	fprintf(nbperf->output, "\tuint32_t idx, i, idx2;\n");
+	if (nbperf->batch) {
+		fprintf(nbperf->output, "\n%suint32_t\n",
+		    nbperf->static_hash ? "static " : "");
+		fprintf(nbperf->output,
+		    "%s(const void *restrict key, size_t keylen)\n",
+		    nbperf->hash_name);
+		fprintf(nbperf->output, "{\n");
+		print_aliases(nbperf);
+	}
+	print_locals(nbperf);
 	fprintf(nbperf->output, "\tuint32_t h[%zu];\n\n", nbperf->hash_size);
 
 	(*nbperf->print_hash)(nbperf, "\t", "key", "keylen", "h");
 
-	fprintf(nbperf->output, "\n\th[0] = h[0] %% %" PRIu32 ";\n",
-	    state->graph.v);
-	fprintf(nbperf->output, "\th[1] = h[1] %% %" PRIu32 ";\n",
-	    state->graph.v);
-	fprintf(nbperf->output, "\th[2] = h[2] %% %" PRIu32 ";\n",
-	    state->graph.v);
-
-	if (state->graph.hash_fudge & 1)
-		fprintf(nbperf->output, "\th[1] ^= (h[0] == h[1]);\n");
+	fprintf(nbperf->output, "\n");
+	print_reduce(nbperf, state, "\t");
+	print_lookup(nbperf, "\t", "return ");
+	fprintf(nbperf->output, "}\n");
 
-	if (state->graph.hash_fudge & 2) {
-		fprintf(nbperf->output,
-		    "\th[2] ^= (h[0] == h[2] || h[1] == h[2]);\n");
-		fprintf(nbperf->output,
-		    "\th[2] ^= 2 * (h[0] == h[2] || h[1] == h[2]);\n");
+	if (nbperf->batch) {
+		print_batch_start(nbperf);
+		print_aliases(nbperf);
+		print_locals(nbperf);
+		print_batch_hash(nbperf);
+		print_reduce(nbperf, state, "\t\t\t");
+		print_batch_lookup(nbperf);
+		print_lookup(nbperf, "\t\t\t", "out[i + j] = ");
+		print_batch_end(nbperf);
 	}
 
-	fprintf(nbperf->output,
-	    "\tidx = 9 + ((g1[h[0] >> 6] >> (h[0] & 63)) &1)\n"
-	    "\t      + ((g1[h[1] >> 6] >> (h[1] & 63)) & 1)\n"
-	    "\t      + ((g1[h[2] >> 6] >> (h[2] & 63)) & 1)\n"
-	    "\t      - ((g2[h[0] >> 6] >> (h[0] & 63)) & 1)\n"
-	    "\t      - ((g2[h[1] >> 6] >> (h[1] & 63)) & 1)\n"
-	    "\t      - ((g2[h[2] >> 6] >> (h[2] & 63)) & 1);\n"
-	    );
-
-	fprintf(nbperf->output,
-	    "\tidx = h[idx %% 3];\n");
-	fprintf(nbperf->output,
-	    "\tidx2 = idx - holes64[idx >> 6] - holes64k[idx >> 16];\n"
-	    "\tidx2 -= popcount64(g1[idx >> 6] & g2[idx >> 6]\n"
-	    "\t                   & (((uint64_t)1 << (idx & 63)) - 1));\n"
-	    "\treturn idx2;\n");
-
-	fprintf(nbperf->output, "}\n");
-
 	if (nbperf->map_output != NULL) {
 		for (i = 0; i < state->graph.e; ++i)
 			fprintf(nbperf->map_output, "%" PRIu32 "\n",
@@ -283,7 +412,17 @@ bpz_compute(struct nbperf *nbperf)
 	if (nbperf->allow_hash_fudging)
 		v = (v + 3) & ~3;
 
+	state.holes64k = NULL;
+	state.holes64 = NULL;
+	state.g = NULL;
+	state.visited = NULL;
+	state.result_map = NULL;
+
 	graph3_setup(&state.graph, v, e);
+	if (SIZED2(_hash)(nbperf, &state.graph))
+		goto failed;
+	if (SIZED2(_output_order)(&state.graph))
+		goto failed;
 
 	state.holes64k = calloc(sizeof(uint32_t), (v + 65535) / 65536);
 	state.holes64 = calloc(sizeof(uint16_t), (v + 63) / 64 );
@@ -295,11 +434,6 @@ bpz_compute(struct nbperf *nbperf)
 	    state.g == NULL || state.visited == NULL ||
 	    state.result_map == NULL)
 		err(1, "malloc failed");
-
-	if (SIZED2(_hash)(nbperf, &state.graph))
-		goto failed;
-	if (SIZED2(_output_order)(&state.graph))
-		goto failed;
 	assign_nodes(&state);
 	print_hash(nbperf, &state);
 
@@ -140,6 +140,44 @@ assign_nodes(struct state *state)
 }
 #endif
 
+static void
+print_reduce(struct nbperf *nbperf, struct state *state, const char *indent)
+{
+	fprintf(nbperf->output, "%sh[0] = h[0] %% %" PRIu32 ";\n",
+	    indent, state->graph.v);
+	fprintf(nbperf->output, "%sh[1] = h[1] %% %" PRIu32 ";\n",
+	    indent, state->graph.v);
+#if GRAPH_SIZE == 3
+	fprintf(nbperf->output, "%sh[2] = h[2] %% %" PRIu32 ";\n",
+	    indent, state->graph.v);
+#endif
+
+	if (state->graph.hash_fudge & 1)
+		fprintf(nbperf->output, "%sh[1] ^= (h[0] == h[1]);\n", indent);
+
+#if GRAPH_SIZE == 3
+	if (state->graph.hash_fudge & 2) {
+		fprintf(nbperf->output,
+		    "%sh[2] ^= (h[0] == h[2] || h[1] == h[2]);\n", indent);
+		fprintf(nbperf->output,
+		    "%sh[2] ^= 2 * (h[0] == h[2] || h[1] == h[2]);\n", indent);
+	}
+#endif
+}
+
+static void
+print_lookup(struct nbperf *nbperf, struct state *state, const char *indent,
+    const char *result)
+{
+#if GRAPH_SIZE == 3
+	fprintf(nbperf->output, "%s%s(g[h[0]] + g[h[1]] + g[h[2]]) %% "
+	    "%" PRIu32 ";\n", indent, result, state->graph.e);
+#else
+	fprintf(nbperf->output, "%s%s(g[h[0]] + g[h[1]]) %% "
+	    "%" PRIu32 ";\n", indent, result, state->graph.e);
+#endif
+}
+
 static void
 print_hash(struct nbperf *nbperf, struct state *state)
 {
@@ -149,12 +187,6 @@ print_hash(struct nbperf *nbperf, struct state *state)
 
 	fprintf(nbperf->output, "#include <stdlib.h>\n\n");
 
-	fprintf(nbperf->output, "%suint32_t\n",
-	    nbperf->static_hash ? "static " : "");
-	fprintf(nbperf->output,
-	    "%s(const void *restrict key, size_t keylen)\n",
-	    nbperf->hash_name);
-	fprintf(nbperf->output, "{\n");
 	if (state->graph.v >= 65536) {
 		g_type = "uint32_t";
 		g_width = 8;
@@ -168,50 +200,49 @@ print_hash(struct nbperf *nbperf, struct state *state)
 		g_width = 2;
 		per_line = 10;
 	}
-	fprintf(nbperf->output, "\tstatic const %s g[%" PRId32 "] = {\n",
-	    g_type, state->graph.v);
+
+	if (!nbperf->batch) {
+		fprintf(nbperf->output, "%suint32_t\n",
+		    nbperf->static_hash ? "static " : "");
+		fprintf(nbperf->output,
+		    "%s(const void *restrict key, size_t keylen)\n",
+		    nbperf->hash_name);
+		fprintf(nbperf->output, "{\n");
+	}
+	print_table_start(nbperf, g_type, "g", state->graph.v);
 	for (i = 0; i < state->graph.v; ++i) {
 		fprintf(nbperf->output, "%s0x%0*" PRIx32 ",%s",
 		    (i % per_line == 0 ? "\t    " : " "),
 		    g_width, state->g[i],
 		    (i % per_line == per_line - 1 ? "\n" : ""));
 	}
-	if (i % per_line != 0)
-		fprintf(nbperf->output, "\n\t};\n");
-	else
-		fprintf(nbperf->output, "\t};\n");
+	print_table_end(nbperf, i % per_line != 0);
+	if (nbperf->batch) {
+		fprintf(nbperf->output, "\n%suint32_t\n",
+		    nbperf->static_hash ? "static " : "");
+		fprintf(nbperf->output,
+		    "%s(const void *restrict key, size_t keylen)\n",
+		    nbperf->hash_name);
+		fprintf(nbperf->output, "{\n");
+		print_table_alias(nbperf, g_type, "g");
+	}
 	fprintf(nbperf->output, "\tuint32_t h[%zu];\n\n", nbperf->hash_size);
 	(*nbperf->print_hash)(nbperf, "\t", "key", "keylen", "h");
 
-	fprintf(nbperf->output, "\n\th[0] = h[0] %% %" PRIu32 ";\n",
-	    state->graph.v);
-	fprintf(nbperf->output, "\th[1] = h[1] %% %" PRIu32 ";\n",
-	    state->graph.v);
-#if GRAPH_SIZE == 3
-	fprintf(nbperf->output, "\th[2] = h[2] %% %" PRIu32 ";\n",
-	    state->graph.v);
-#endif
-
-	if (state->graph.hash_fudge & 1)
-		fprintf(nbperf->output, "\th[1] ^= (h[0] == h[1]);\n");
+	fprintf(nbperf->output, "\n");
+	print_reduce(nbperf, state, "\t");
+	print_lookup(nbperf, state, "\t", "return ");
+	fprintf(nbperf->output, "}\n");
 
-#if GRAPH_SIZE == 3
-	if (state->graph.hash_fudge & 2) {
-		fprintf(nbperf->output,
-		    "\th[2] ^= (h[0] == h[2] || h[1] == h[2]);\n");
-		fprintf(nbperf->output,
-		    "\th[2] ^= 2 * (h[0] == h[2] || h[1] == h[2]);\n");
+	if (nbperf->batch) {
+		print_batch_start(nbperf);
+		print_table_alias(nbperf, g_type, "g");
+		print_batch_hash(nbperf);
+		print_reduce(nbperf, state, "\t\t\t");
+		print_batch_lookup(nbperf);
+		print_lookup(nbperf, state, "\t\t\t", "out[i + j] = ");
+		print_batch_end(nbperf);
 	}
-#endif
-
-#if GRAPH_SIZE == 3
-	fprintf(nbperf->output, "\treturn (g[h[0]] + g[h[1]] + g[h[2]]) %% "
-	    "%" PRIu32 ";\n", state->graph.e);
-#else
-	fprintf(nbperf->output, "\treturn (g[h[0]] + g[h[1]]) %% "
-	    "%" PRIu32 ";\n", state->graph.e);
-#endif
-	fprintf(nbperf->output, "}\n");
 
 	if (nbperf->map_output != NULL) {
 		for (i = 0; i < state->graph.e; ++i)
@@ -267,16 +298,19 @@ chm_compute(struct nbperf *nbperf)
 		v = (v + 1) & ~1;
 #endif
 
-	state.g = calloc(sizeof(uint32_t), v);
-	state.visited = calloc(sizeof(uint8_t), v);
-	if (state.g == NULL || state.visited == NULL)
-		err(1, "malloc failed");
+	state.g = NULL;
+	state.visited = NULL;
 
 	SIZED2(_setup)(&state.graph, v, e);
 	if (SIZED2(_hash)(nbperf, &state.graph))
 		goto failed;
 	if (SIZED2(_output_order)(&state.graph))
 		goto failed;
+
+	state.g = calloc(sizeof(uint32_t), v);
+	state.visited = calloc(sizeof(uint8_t), v);
+	if (state.g == NULL || state.visited == NULL)
+		err(1, "malloc failed");
 	assign_nodes(&state);
 	print_hash(nbperf, &state);
 
@@ -35,6 +35,9 @@
 #include "nbtool_config.h"
 #endif
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include <err.h>
 #include <errno.h>
 #include <inttypes.h>
@@ -56,7 +59,7 @@ static noreturn
 void usage(const char *argv0)
 {
 	fprintf(stderr,
-	    "%s [-ps] [-c utilisation] [-i iterations] [-n name] "
+	    "%s [-blPps] [-c utilisation] [-i iterations] [-n name] "
 	    "[-o output] input\n",
 	    argv0 ? argv0 : "nbperf");
 	exit(1);
@@ -100,6 +103,201 @@ set_hash(struct nbperf *nbperf, const char *arg)
 	errx(1, "Unknown hash function: %s", arg);
 }
 
+/*
+ * With -b, the tables are shared by the hash function and its batch
+ * version. They are written at file scope, prefixed with the name of
+ * the hash function, and both functions refer to them through a local
+ * pointer with the short name.
+ */
+void
+print_table_start(struct nbperf *nbperf, const char *type, const char *name,
+    size_t size)
+{
+	if (nbperf->batch)
+		fprintf(nbperf->output, "static const %s %s_%s[%zu] = {\n",
+		    type, nbperf->hash_name, name, size);
+	else
+		fprintf(nbperf->output, "\tstatic const %s %s[%zu] = {\n",
+		    type, name, size);
+}
+
+void
+print_table_end(struct nbperf *nbperf, int newline)
+{
+	fprintf(nbperf->output, "%s%s};\n", newline ? "\n" : "",
+	    nbperf->batch ? "" : "\t");
+}
+
+void
+print_table_alias(struct nbperf *nbperf, const char *type, const char *name)
+{
+	fprintf(nbperf->output, "\tconst %s *const %s = %s_%s;\n",
+	    type, name, nbperf->hash_name, name);
+}
+
+/*
+ * The batch function handles BATCH_KEYS keys at a time in stages:
+ * all keys are hashed, then all hashes are reduced to vertices, then
+ * the tables are read for all keys. The steps for different keys are
+ * independent, so the CPU can overlap them and the table loads.
+ * Between print_batch_hash and print_batch_lookup, the algorithm
+ * writes the reduction of h, after print_batch_lookup the assignment
+ * of out[i + j].
+ */
+#define	BATCH_KEYS	8
+
+void
+print_batch_start(struct nbperf *nbperf)
+{
+	fprintf(nbperf->output, "\n%svoid\n",
+	    nbperf->static_hash ? "static " : "");
+	fprintf(nbperf->output,
+	    "%s_batch(const void *const *restrict keys,\n"
+	    "    const size_t *restrict keylens, uint32_t *restrict out, "
+	    "size_t n)\n", nbperf->hash_name);
+	fprintf(nbperf->output, "{\n");
+}
+
+void
+print_batch_hash(struct nbperf *nbperf)
+{
+	fprintf(nbperf->output, "\tuint32_t hh[%d][%zu], *h;\n",
+	    BATCH_KEYS, nbperf->hash_size);
+	fprintf(nbperf->output, "\tsize_t i, j, cnt;\n\n");
+	fprintf(nbperf->output, "\tfor (i = 0; i < n; i += cnt) {\n");
+	fprintf(nbperf->output, "\t\tcnt = n - i < %d ? n - i : %d;\n",
+	    BATCH_KEYS, BATCH_KEYS);
+	fprintf(nbperf->output, "\t\tfor (j = 0; j < cnt; ++j)\n");
+	(*nbperf->print_hash)(nbperf, "\t\t\t", "keys[i + j]",
+	    "keylens[i + j]", "hh[j]");
+	fprintf(nbperf->output, "\t\tfor (j = 0; j < cnt; ++j) {\n");
+	fprintf(nbperf->output, "\t\t\th = hh[j];\n");
+}
+
+void
+print_batch_lookup(struct nbperf *nbperf)
+{
+	fprintf(nbperf->output, "\t\t}\n");
+	fprintf(nbperf->output, "\t\tfor (j = 0; j < cnt; ++j) {\n");
+	fprintf(nbperf->output, "\t\t\th = hh[j];\n");
+}
+
+void
+print_batch_end(struct nbperf *nbperf)
+{
+	fprintf(nbperf->output, "\t\t}\n");
+	fprintf(nbperf->output, "\t}\n");
+	fprintf(nbperf->output, "}\n");
+}
+
+static void
+read_keys(struct nbperf *nbperf, FILE *input)
+{
+	size_t curlen = 0, curalloc = 0;
+	char *line;
+	ssize_t line_len;
+	size_t line_allocated;
+	const void **keys = NULL;
+	size_t *keylens = NULL;
+
+	line = NULL;
+	line_allocated = 0;
+	while ((line_len = getline(&line, &line_allocated, input)) != -1) {
+		if (line_len && line[line_len - 1] == '\n')
+			--line_len;
+		if (curlen == curalloc) {
+			if (curalloc < 256)
+				curalloc = 256;
+			else
+				curalloc += curalloc;
+			keys = realloc(keys, curalloc * sizeof(*keys));
+			if (keys == NULL)
+				err(1, "realloc failed");
+			keylens = realloc(keylens,
+			    curalloc * sizeof(*keylens));
+			if (keylens == NULL)
+				err(1, "realloc failed");
+		}
+		if ((keys[curlen] = strndup(line, line_len)) == NULL)
+			err(1, "malloc failed");
+		keylens[curlen] = line_len;
+		++curlen;
+	}
+	free(line);
+
+	nbperf->n = curlen;
+	nbperf->keys = keys;
+	nbperf->keylens = keylens;
+}
+
+/*
+ * For large key sets, map the input file or read it into one buffer
+ * and let the keys point into it. The lines are counted first, so the
+ * key arrays are allocated once with their final size.
+ */
+static void
+read_keys_buffer(struct nbperf *nbperf, FILE *input)
+{
+	struct stat sb;
+	char *buf, *p, *end, *eol;
+	size_t len, alloc, n, i;
+	const void **keys;
+	size_t *keylens;
+
+	buf = NULL;
+	len = 0;
+	if (fstat(fileno(input), &sb) == 0 && S_ISREG(sb.st_mode) &&
+	    sb.st_size > 0 && (uintmax_t)sb.st_size <= SIZE_MAX) {
+		len = (size_t)sb.st_size;
+		buf = mmap(NULL, len, PROT_READ, MAP_PRIVATE,
+		    fileno(input), 0);
+		if (buf == MAP_FAILED)
+			buf = NULL;
+	}
+	if (buf == NULL) {
+		len = 0;
+		alloc = 65536;
+		if ((buf = malloc(alloc)) == NULL)
+			err(1, "malloc failed");
+		while ((n = fread(buf + len, 1, alloc - len, input)) > 0) {
+			len += n;
+			if (len < alloc)
+				continue;
+			alloc += alloc;
+			if ((buf = realloc(buf, alloc)) == NULL)
+				err(1, "realloc failed");
+		}
+		if (ferror(input))
+			err(1, "can't read input file");
+	}
+
+	end = buf + len;
+	n = 0;
+	for (p = buf; p < end; p = eol + 1) {
+		if ((eol = memchr(p, '\n', end - p)) == NULL)
+			eol = end;
+		++n;
+	}
+
+	keys = calloc(sizeof(*keys), n ? n : 1);
+	keylens = calloc(sizeof(*keylens), n ? n : 1);
+	if (keys == NULL || keylens == NULL)
+		err(1, "malloc failed");
+
+	i = 0;
+	for (p = buf; p < end; p = eol + 1) {
+		if ((eol = memchr(p, '\n', end - p)) == NULL)
+			eol = end;
+		keys[i] = p;
+		keylens[i] = eol - p;
+		++i;
+	}
+
+	nbperf->n = n;
+	nbperf->keys = keys;
+	nbperf->keylens = keylens;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -112,22 +310,19 @@ main(int argc, char **argv)
 	    .check_duplicates = 0,
 	    .has_duplicates = 0,
 	    .allow_hash_fudging = 0,
+	    .packed_g = 0,
+	    .batch = 0,
 	};
 	FILE *input;
-	size_t curlen = 0, curalloc = 0;
-	char *line, *eos;
-	ssize_t line_len;
-	size_t line_allocated;
-	const void **keys = NULL;
-	size_t *keylens = NULL;
+	char *eos;
 	uint32_t max_iterations = 0xffffffU;
 	long long tmp;
-	int looped, ch;
+	int looped, ch, lflag = 0;
 	int (*build_hash)(struct nbperf *) = chm_compute;
 
 	set_hash(&nbperf, "mi_vector_hash");
 
-	while ((ch = getopt(argc, argv, "a:c:fh:i:m:n:o:ps")) != -1) {
+	while ((ch = getopt(argc, argv, "a:bc:fh:i:lm:n:o:Pps")) != -1) {
 		switch (ch) {
 		case 'a':
 			/* Accept bdz as alias for netbsd-6 compat. */
@@ -141,6 +336,9 @@ main(int argc, char **argv)
 			else
 				errx(1, "Unsupport algorithm: %s", optarg);
 			break;
+		case 'b':
+			nbperf.batch = 1;
+			break;
 		case 'c':
 			errno = 0;
 			nbperf.c = strtod(optarg, &eos);
@@ -162,6 +360,9 @@ main(int argc, char **argv)
 				    "a 32bit integer");
 			max_iterations = (uint32_t)tmp;
 			break;
+		case 'l':
+			lflag = 1;
+			break;
 		case 'm':
 			if (nbperf.map_output)
 				fclose(nbperf.map_output);
@@ -179,6 +380,9 @@ main(int argc, char **argv)
 			if (nbperf.output == NULL)
 				err(2, "cannot open output file");
 			break;
+		case 'P':
+			nbperf.packed_g = 1;
+			break;
 		case 'p':
 			/* no-op */
 			break;
@@ -206,38 +410,14 @@ main(int argc, char **argv)
 	if (nbperf.output == NULL)
 		nbperf.output = stdout;
 
-	line = NULL;
-	line_allocated = 0;
-	while ((line_len = getline(&line, &line_allocated, input)) != -1) {
-		if (line_len && line[line_len - 1] == '\n')
-			--line_len;
-		if (curlen == curalloc) {
-			if (curalloc < 256)
-				curalloc = 256;
-			else
-				curalloc += curalloc;
-			keys = realloc(keys, curalloc * sizeof(*keys));
-			if (keys == NULL)
-				err(1, "realloc failed");
-			keylens = realloc(keylens,
-			    curalloc * sizeof(*keylens));
-			if (keylens == NULL)
-				err(1, "realloc failed");
-		}
-		if ((keys[curlen] = strndup(line, line_len)) == NULL)
-			err(1, "malloc failed");
-		keylens[curlen] = line_len;
-		++curlen;
-	}
-	free(line);
+	if (lflag)
+		read_keys_buffer(&nbperf, input);
+	else
+		read_keys(&nbperf, input);
 
 	if (input != stdin)
 		fclose(input);
 
-	nbperf.n = curlen;
-	nbperf.keys = keys;
-	nbperf.keylens = keylens;
-
 	looped = 0;
 	int rv;
 	for (;;) {
@@ -39,6 +39,8 @@ struct nbperf {
 	const char *hash_name;
 	int static_hash;
 	int allow_hash_fudging;
+	int packed_g;
+	int batch;
 	size_t n;
 	const void *restrict *keys;
 	const size_t *keylens;
@@ -55,6 +57,14 @@ struct nbperf {
 	uint32_t seed[1];
 };
 
+void	print_table_start(struct nbperf *, const char *, const char *, size_t);
+void	print_table_end(struct nbperf *, int);
+void	print_table_alias(struct nbperf *, const char *, const char *);
+void	print_batch_start(struct nbperf *);
+void	print_batch_hash(struct nbperf *);
+void	print_batch_lookup(struct nbperf *);
+void	print_batch_end(struct nbperf *);
+
 int	chm_compute(struct nbperf *);
 int	chm3_compute(struct nbperf *);
 int	bpz_compute(struct nbperf *);
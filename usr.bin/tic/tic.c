@@ -35,6 +35,7 @@
 #include <sys/queue.h>
 #include <sys/stat.h>
 
+#include <cdbr.h>
 #include <cdbw.h>
 #include <ctype.h>
 #include <err.h>
@@ -42,6 +43,7 @@
 #include <getopt.h>
 #include <limits.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <search.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -60,9 +62,60 @@ typedef struct term {
 	TIC *tic;
 	uint32_t id;
 	struct term *base_term;
+	int use_state;
+	uint8_t *data;
+	ssize_t datalen;
 } TERM;
 static STAILQ_HEAD(, term) terms = STAILQ_HEAD_INITIALIZER(terms);
 
+/* States of a term whilst resolving its use records */
+#define	USE_PENDING	0
+#define	USE_ACTIVE	1
+#define	USE_DONE	2
+#define	USE_FAILED	3
+
+/* The terms currently being resolved, for reporting use cycles */
+static TERM **use_stack;
+static size_t use_depth, use_stacklen;
+
+/* A source entry, compiled by a worker before the terms are stored */
+typedef struct span {
+	TBUF buf;
+	TIC *tic;
+#ifdef TERMINFO_COMPAT
+	TIC *tic_v1;
+#endif
+	bool warned;
+} SPAN;
+static SPAN *spans;
+static size_t nspans, spanslen;
+
+/* Spans and terms are handed out to workers in chunks of this size */
+#define	JOB_CHUNK	16
+
+struct jobs {
+	pthread_mutex_t lock;
+	size_t next, n;
+	void (*fn)(size_t, void *);
+	void *arg;
+};
+
+static long njobs;
+
+/* With -p strings are pooled, the pool being the first record written */
+static int pflag;
+static TIPOOL pool;
+#define	POOL_ID		0
+
+/*
+ * With -u the records of the existing database that the source does
+ * not replace are copied across, renumbered by odb_ids.
+ */
+static int uflag;
+static struct cdbr *odb;
+static uint32_t *odb_ids, odb_entries, odb_pool, odb_seed;
+#define	NO_ID		UINT32_MAX
+
 static int error_exit;
 static int Sflag;
 static size_t nterm, nalias;
@@ -89,6 +142,19 @@ grow_tbuf(TBUF *tbuf, size_t len)
 	return buf;
 }
 
+static void
+flatten_term(TERM *term)
+{
+
+	if (pflag)
+		term->datalen = _ti_flatten_pooled(&term->data, term->tic,
+		    &pool, POOL_ID);
+	else
+		term->datalen = _ti_flatten(&term->data, term->tic);
+	if (term->datalen == -1)
+		term->data = NULL;
+}
+
 static int
 save_term(struct cdbw *db, TERM *term)
 {
@@ -112,15 +178,15 @@ save_term(struct cdbw *db, TERM *term)
 		return 0;
 	}
 
-	len = _ti_flatten(&buf, term->tic);
-	if (len == -1)
+	if (term->data == NULL)
 		return -1;
 
-	if (cdbw_put_data(db, buf, len, &term->id))
+	if (cdbw_put_data(db, term->data, term->datalen, &term->id))
 		err(EXIT_FAILURE, "cdbw_put_data");
 	if (cdbw_put_key(db, term->name, slen, term->id))
 		err(EXIT_FAILURE, "cdbw_put_key");
-	free(buf);
+	free(term->data);
+	term->data = NULL;
 	return 0;
 }
 
@@ -210,9 +276,24 @@ alias_terms(TERM *term)
 }
 
 static int
-process_entry(TBUF *buf, int flags)
+store_entry(TIC *tic)
 {
 	TERM *term;
+
+	if (find_term(tic->name) != NULL) {
+		dowarn("%s: duplicate entry", tic->name);
+		_ti_freetic(tic);
+		return -1;
+	}
+	term = store_term(tic->name, NULL);
+	term->tic = tic;
+	alias_terms(term);
+	return 0;
+}
+
+static int
+process_entry(TBUF *buf, int flags)
+{
 	TIC *tic;
 #ifdef TERMINFO_COMPAT
 	TBUF sbuf = *buf;
@@ -231,15 +312,8 @@ process_entry(TBUF *buf, int flags)
 	tic = _ti_compile(buf->buf, flags);
 	if (tic == NULL)
 		return 0;
-
-	if (find_term(tic->name) != NULL) {
-		dowarn("%s: duplicate entry", tic->name);
-		_ti_freetic(tic);
+	if (store_entry(tic) == -1)
 		return 0;
-	}
-	term = store_term(tic->name, NULL);
-	term->tic = tic;
-	alias_terms(term);
 
 #ifdef TERMINFO_COMPAT
 	if (tic->rtype == TERMINFO_RTYPE)
@@ -249,6 +323,193 @@ process_entry(TBUF *buf, int flags)
 	return 0;
 }
 
+static void *
+job_worker(void *arg)
+{
+	struct jobs *jobs = arg;
+	size_t i, end;
+
+	for (;;) {
+		pthread_mutex_lock(&jobs->lock);
+		i = jobs->next;
+		end = jobs->n - i > JOB_CHUNK ? i + JOB_CHUNK : jobs->n;
+		jobs->next = end;
+		pthread_mutex_unlock(&jobs->lock);
+		if (i == end)
+			break;
+		for (; i < end; i++)
+			jobs->fn(i, jobs->arg);
+	}
+	return NULL;
+}
+
+/*
+ * Call fn for 0 .. n - 1 on up to njobs threads, including this one.
+ * If a thread cannot be created we just make do with fewer.
+ */
+static void
+run_jobs(size_t n, void (*fn)(size_t, void *), void *arg)
+{
+	struct jobs jobs;
+	pthread_t *threads;
+	size_t i, nthreads;
+
+	jobs.next = 0;
+	jobs.n = n;
+	jobs.fn = fn;
+	jobs.arg = arg;
+	if (pthread_mutex_init(&jobs.lock, NULL) != 0)
+		err(EXIT_FAILURE, "pthread_mutex_init");
+
+	nthreads = njobs > 1 ? (size_t)njobs - 1 : 0;
+	if (nthreads > n / JOB_CHUNK)
+		nthreads = n / JOB_CHUNK;
+	threads = NULL;
+	if (nthreads != 0) {
+		threads = calloc(nthreads, sizeof(*threads));
+		if (threads == NULL)
+			nthreads = 0;
+	}
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&threads[i], NULL, job_worker, &jobs) != 0)
+			break;
+	nthreads = i;
+
+	job_worker(&jobs);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	pthread_mutex_destroy(&jobs.lock);
+}
+
+/* Take ownership of the entry in buf, rewinding it for the next one. */
+static void
+add_span(TBUF *buf)
+{
+	SPAN *span;
+
+	if (buf->bufpos == 0)
+		return;
+	if (nspans == spanslen) {
+		spanslen = spanslen == 0 ? 1024 : spanslen * 2;
+		spans = realloc(spans, spanslen * sizeof(*spans));
+		if (spans == NULL)
+			err(EXIT_FAILURE, NULL);
+	}
+	span = &spans[nspans++];
+	memset(span, 0, sizeof(*span));
+	span->buf = *buf;
+	buf->buf = NULL;
+	buf->buflen = buf->bufpos = 0;
+}
+
+/*
+ * Compile a copy of the span as process_entry would, but quietly.
+ * If the compile warned, or gave up before there was a term to count
+ * the warnings against, the result is thrown away and the span is
+ * processed again when the terms are stored so the warnings come out
+ * in order.
+ */
+static void
+compile_span(size_t i, void *arg)
+{
+	SPAN *span = &spans[i];
+	int flags = *(int *)arg & ~TIC_WARNING;
+	char *buf;
+	size_t len;
+
+	len = span->buf.bufpos;
+	if (isspace((unsigned char)*span->buf.buf))
+		return;
+	buf = malloc(len);
+	if (buf == NULL)
+		err(EXIT_FAILURE, NULL);
+	memcpy(buf, span->buf.buf, len - 1);
+	buf[len - 1] = '\0';
+
+	span->tic = _ti_compile(buf, flags);
+	if (span->tic == NULL || span->tic->warnings != 0)
+		span->warned = true;
+#ifdef TERMINFO_COMPAT
+	else if (span->tic->rtype == TERMINFO_RTYPE) {
+		span->tic_v1 = _ti_compile(buf, flags | TIC_COMPAT_V1);
+		if (span->tic_v1 == NULL || span->tic_v1->warnings != 0)
+			span->warned = true;
+	}
+#endif
+	if (span->warned) {
+		_ti_freetic(span->tic);
+		span->tic = NULL;
+#ifdef TERMINFO_COMPAT
+		_ti_freetic(span->tic_v1);
+		span->tic_v1 = NULL;
+#endif
+	}
+	free(buf);
+}
+
+/* Compile the spans in parallel and store their terms in order. */
+static void
+process_spans(int flags)
+{
+	SPAN *span;
+	size_t i;
+
+	run_jobs(nspans, compile_span, &flags);
+
+	for (i = 0; i < nspans; i++) {
+		span = &spans[i];
+		if (span->warned)
+			process_entry(&span->buf, flags);
+		else if (span->tic != NULL) {
+#ifdef TERMINFO_COMPAT
+			if (store_entry(span->tic) == -1)
+				_ti_freetic(span->tic_v1);
+			else if (span->tic_v1 != NULL)
+				store_entry(span->tic_v1);
+#else
+			store_entry(span->tic);
+#endif
+		}
+		free(span->buf.buf);
+	}
+	free(spans);
+	spans = NULL;
+	nspans = spanslen = 0;
+}
+
+static void
+flatten_job(size_t i, void *arg)
+{
+	TERM **list = arg;
+
+	flatten_term(list[i]);
+}
+
+/* Flatten every term on the list in parallel, ready to be saved. */
+static void
+flatten_terms(void)
+{
+	TERM *term, **list;
+	size_t i, n;
+
+	list = malloc(nterm * sizeof(*list));
+	if (list == NULL)
+		err(EXIT_FAILURE, NULL);
+	n = 0;
+	STAILQ_FOREACH(term, &terms, next) {
+		if (term->base_term == NULL)
+			list[n++] = term;
+	}
+	/* The pool is filled in list order so the database is stable. */
+	if (pflag) {
+		for (i = 0; i < n; i++)
+			flatten_term(list[i]);
+	} else
+		run_jobs(n, flatten_job, list);
+	free(list);
+}
+
 static void
 merge(TIC *rtic, TIC *utic, int flags)
 {
@@ -414,105 +675,190 @@ err:
 }
 #endif
 
-static size_t
-merge_use(int flags)
+/*
+ * Return the type byte of the next use record in tic's extras
+ * at or after *offp, setting *offp to the start of the record.
+ */
+static const char *
+find_use(TIC *tic, size_t *offp)
+{
+	const char *cap, *code, *end;
+	uint16_t num;
+
+	cap = tic->extras.buf + *offp;
+	end = tic->extras.buf + tic->extras.bufpos;
+	while (cap < end) {
+		code = cap;
+		num = _ti_decode_16(&cap);
+		if (strcmp(cap, "use") == 0) {
+			*offp = (size_t)(code - tic->extras.buf);
+			return cap + num;
+		}
+		cap += num;
+		switch (*cap++) {
+		case 'f':
+			cap++;
+			break;
+		case 'n':
+			cap += _ti_numsize(tic);
+			break;
+		case 's':
+			num = _ti_decode_16(&cap);
+			cap += num;
+			break;
+		}
+	}
+	return NULL;
+}
+
+/* Remove the string use record found at off from tic's extras. */
+static void
+remove_use(TIC *tic, size_t off)
 {
-	size_t skipped, merged, memn;
+	char *scap;
 	const char *cap;
-	char *name, *basename;
 	uint16_t num;
+
+	scap = tic->extras.buf + off;
+	cap = scap + sizeof(uint16_t) + 4 + 1;
+	num = _ti_decode_16(&cap);
+	cap += num;
+	memmove(scap, cap, tic->extras.bufpos - (size_t)(cap - tic->extras.buf));
+	tic->extras.bufpos -= (size_t)(cap - scap);
+	tic->extras.entries--;
+}
+
+static void
+report_cycle(TERM *term)
+{
+	size_t i, j, len;
+	char *names, *p;
+
+	for (i = use_depth; i > 0; i--)
+		if (use_stack[i - 1] == term)
+			break;
+	if (i == 0) {
+		dowarn("%s: circular use detected", term->tic->name);
+		return;
+	}
+	len = strlen(term->tic->name) + 1;
+	for (j = i - 1; j < use_depth; j++)
+		len += strlen(use_stack[j]->tic->name) + 4;
+	names = p = malloc(len);
+	if (names == NULL)
+		err(EXIT_FAILURE, NULL);
+	for (j = i - 1; j < use_depth; j++)
+		p += sprintf(p, "%s -> ", use_stack[j]->tic->name);
+	strcpy(p, term->tic->name);
+	dowarn("circular use detected: %s", names);
+	free(names);
+}
+
+/*
+ * Merge the use records of term in order, resolving each used term
+ * first so that every term is merged exactly once.
+ * Returns -1 if a use could not be resolved, leaving it and any
+ * following use records in place.
+ */
+static int
+resolve_use(TERM *term, int flags)
+{
+	size_t off;
+	const char *cap;
+	char *name, *basename;
+	int rv;
 	TIC *rtic, *utic;
-	TERM *term, *uterm;
+	TERM *uterm;
 #ifdef TERMINFO_COMPAT
 	bool promoted;
 #endif
 
-	skipped = merged = 0;
-	STAILQ_FOREACH(term, &terms, next) {
-		if (term->base_term != NULL)
-			continue;
-		rtic = term->tic;
-		basename = _ti_getname(TERMINFO_RTYPE_O1, rtic->name);
+	switch (term->use_state) {
+	case USE_DONE:
+		return 0;
+	case USE_FAILED:
+		return -1;
+	case USE_ACTIVE:
+		report_cycle(term);
+		return -1;
+	}
+
+	if (use_depth == use_stacklen) {
+		use_stacklen = use_stacklen == 0 ? 16 : use_stacklen * 2;
+		use_stack = realloc(use_stack,
+		    use_stacklen * sizeof(*use_stack));
+		if (use_stack == NULL)
+			err(EXIT_FAILURE, NULL);
+	}
+	use_stack[use_depth++] = term;
+	term->use_state = USE_ACTIVE;
+
+	rtic = term->tic;
+	basename = _ti_getname(TERMINFO_RTYPE_O1, rtic->name);
+	if (basename == NULL)
+		err(EXIT_FAILURE, "_ti_getname");
 #ifdef TERMINFO_COMPAT
-		promoted = false;
+	promoted = false;
 #endif
-		while ((cap = _ti_find_extra(rtic, &rtic->extras, "use"))
-		    != NULL) {
-			if (*cap++ != 's') {
-				dowarn("%s: use is not string", rtic->name);
-				break;
-			}
-			cap += sizeof(uint16_t);
-			if (strcmp(basename, cap) == 0) {
-				dowarn("%s: uses itself", rtic->name);
-				goto remove;
-			}
-			name = _ti_getname(rtic->rtype, cap);
-			if (name == NULL) {
-				dowarn("%s: ???: %s", rtic->name, cap);
-				goto remove;
-			}
-			uterm = find_term(name);
-			free(name);
-			if (uterm == NULL)
-				uterm = find_term(cap);
-			if (uterm != NULL && uterm->base_term != NULL)
-				uterm = uterm->base_term;
-			if (uterm == NULL) {
-				dowarn("%s: no use record for %s",
-				    rtic->name, cap);
-				goto remove;
-			}
-			utic = uterm->tic;
-			if (strcmp(utic->name, rtic->name) == 0) {
-				dowarn("%s: uses itself", rtic->name);
-				goto remove;
-			}
-			if (_ti_find_extra(utic, &utic->extras, "use")
-			    != NULL) {
-				skipped++;
-				break;
-			}
+	rv = 0;
+	off = 0;
+	while ((cap = find_use(rtic, &off)) != NULL) {
+		if (*cap++ != 's') {
+			dowarn("%s: use is not string", rtic->name);
+			rv = -1;
+			break;
+		}
+		cap += sizeof(uint16_t);
+		if (strcmp(basename, cap) == 0) {
+			dowarn("%s: uses itself", rtic->name);
+			goto remove;
+		}
+		name = _ti_getname(rtic->rtype, cap);
+		if (name == NULL) {
+			dowarn("%s: ???: %s", rtic->name, cap);
+			goto remove;
+		}
+		uterm = find_term(name);
+		free(name);
+		if (uterm == NULL)
+			uterm = find_term(cap);
+		if (uterm != NULL && uterm->base_term != NULL)
+			uterm = uterm->base_term;
+		if (uterm == NULL) {
+			dowarn("%s: no use record for %s", rtic->name, cap);
+			goto remove;
+		}
+		utic = uterm->tic;
+		if (strcmp(utic->name, rtic->name) == 0) {
+			dowarn("%s: uses itself", rtic->name);
+			goto remove;
+		}
+		if (resolve_use(uterm, flags) == -1) {
+			rv = -1;
+			break;
+		}
 
 #ifdef TERMINFO_COMPAT
-			/* If we need to merge in a term that requires
-			 * this term to be promoted, we need to duplicate
-			 * this term, promote it and append it to our list. */
-			if (!promoted && rtic->rtype != TERMINFO_RTYPE) {
-				if (promote(rtic, utic) == -1)
-					err(EXIT_FAILURE, "promote");
-				promoted = true;
-			}
+		/* If we need to merge in a term that requires
+		 * this term to be promoted, we need to duplicate
+		 * this term, promote it and append it to our list. */
+		if (!promoted && rtic->rtype != TERMINFO_RTYPE) {
+			if (promote(rtic, utic) == -1)
+				err(EXIT_FAILURE, "promote");
+			promoted = true;
+		}
 #endif
 
-			merge(rtic, utic, flags);
+		merge(rtic, utic, flags);
 	remove:
-			/* The pointers may have changed, find the use again */
-			cap = _ti_find_extra(rtic, &rtic->extras, "use");
-			if (cap == NULL)
-				dowarn("%s: use no longer exists - impossible",
-					rtic->name);
-			else {
-				char *scap = (char *)cap -
-				    (4 + sizeof(uint16_t));
-				cap++;
-				num = _ti_decode_16(&cap);
-				cap += num;
-				memn = rtic->extras.bufpos -
-				    (cap - rtic->extras.buf);
-				memmove(scap, cap, memn);
-				rtic->extras.bufpos -= cap - scap;
-				cap = scap;
-				rtic->extras.entries--;
-				merged++;
-			}
-		}
-		free(basename);
+		/* Merging only appends, so the record is still at off */
+		remove_use(rtic, off);
 	}
+	free(basename);
 
-	if (merged == 0 && skipped != 0)
-		dowarn("circular use detected");
-	return merged;
+	use_depth--;
+	term->use_state = rv == 0 ? USE_DONE : USE_FAILED;
+	return rv;
 }
 
 static int
@@ -580,18 +926,278 @@ print_dump(int argc, char **argv)
 	return n;
 }
 
+/* Return the name a record is keyed by, or NULL if it has none. */
+static const char *
+record_name(const void *data, size_t len)
+{
+	const char *cap;
+	size_t off, nlen;
+
+	if (len == 0)
+		return NULL;
+	switch (*(const char *)data) {
+	case TERMINFO_RTYPE_O1:
+	case TERMINFO_RTYPE:
+		off = 1;
+		break;
+	case TERMINFO_ALIAS:
+		off = 1 + sizeof(uint32_t);
+		break;
+	case TERMINFO_RTYPE_POOLED:
+		off = 1 + sizeof(uint32_t) + 1;
+		break;
+	default:
+		return NULL;
+	}
+	if (len < off + sizeof(uint16_t))
+		return NULL;
+	cap = (const char *)data + off;
+	nlen = _ti_decode_16(&cap);
+	off += sizeof(uint16_t);
+	if (nlen == 0 || nlen > len - off || cap[nlen - 1] != '\0')
+		return NULL;
+	return cap;
+}
+
+/* Return the id a record refers to, the term of an alias or a pool. */
+static uint32_t
+record_ref(const void *data, size_t len)
+{
+	const char *cap;
+
+	if (len < 1 + sizeof(uint32_t))
+		return NO_ID;
+	switch (*(const char *)data) {
+	case TERMINFO_ALIAS:
+	case TERMINFO_RTYPE_POOLED:
+		cap = (const char *)data + 1;
+		return _ti_decode_32(&cap);
+	}
+	return NO_ID;
+}
+
+/* Return true if the source replaces the record called name. */
+static bool
+replaced(const char *name, int argc, char **argv)
+{
+	char *basename;
+	TERM *term;
+	int i;
+
+	basename = _ti_getname(TERMINFO_RTYPE_O1, name);
+	if (basename == NULL)
+		err(EXIT_FAILURE, "_ti_getname");
+	term = find_newest_term(basename);
+	free(basename);
+	if (term == NULL || argc == 0)
+		return term != NULL;
+	for (i = 0; i < argc; i++) {
+		if (find_newest_term(argv[i]) == term)
+			return true;
+	}
+	return false;
+}
+
+static void
+free_database(void *cookie, void *base, size_t size)
+{
+
+	(void)cookie;
+	(void)size;
+	free(base);
+}
+
+/*
+ * Read the database being updated and work out which of its records
+ * to keep, loading its string pool to share if pooling.
+ */
+static void
+read_database(const char *dbname, int argc, char **argv)
+{
+	struct stat st;
+	const void *data;
+	const char *cap;
+	char *buf;
+	size_t i, len;
+	ssize_t r;
+	uint32_t id, ref;
+	int fd;
+
+	fd = open(dbname, O_RDONLY);
+	if (fd == -1) {
+		/* Nothing to update, so write a new database. */
+		if (errno == ENOENT)
+			return;
+		err(EXIT_FAILURE, "open %s", dbname);
+	}
+	if (fstat(fd, &st) == -1)
+		err(EXIT_FAILURE, "fstat %s", dbname);
+	if (st.st_size < 40 || (uintmax_t)st.st_size > SIZE_MAX)
+		errx(EXIT_FAILURE, "%s: not a terminfo database", dbname);
+	len = (size_t)st.st_size;
+	buf = malloc(len);
+	if (buf == NULL)
+		err(EXIT_FAILURE, NULL);
+	for (i = 0; i < len; i += (size_t)r) {
+		r = read(fd, buf + i, len - i);
+		if (r == -1)
+			err(EXIT_FAILURE, "read %s", dbname);
+		if (r == 0)
+			errx(EXIT_FAILURE, "%s: truncated", dbname);
+	}
+	close(fd);
+	odb = cdbr_open_mem(buf, len, CDBR_DEFAULT, free_database, NULL);
+	if (odb == NULL) {
+		free(buf);
+		errx(EXIT_FAILURE, "%s: not a terminfo database", dbname);
+	}
+	/* cdbr does not expose the seed, so take it from the header. */
+	cap = buf + 36;
+	odb_seed = _ti_decode_32(&cap);
+
+	odb_pool = NO_ID;
+	odb_entries = cdbr_entries(odb);
+	odb_ids = malloc((odb_entries + 1) * sizeof(*odb_ids));
+	if (odb_ids == NULL)
+		err(EXIT_FAILURE, NULL);
+
+	/* Descriptions and pools first, aliases need their term kept. */
+	for (id = 0; id < odb_entries; id++) {
+		odb_ids[id] = NO_ID;
+		if (cdbr_get(odb, id, &data, &len))
+			err(EXIT_FAILURE, "cdbr_get");
+		if (len == 0)
+			continue;
+		switch (*(const char *)data) {
+		case TERMINFO_ALIAS:
+			continue;
+		case TERMINFO_POOL:
+			/* A pooled database shares the one pool. */
+			if (pflag) {
+				if (odb_pool != NO_ID)
+					errx(EXIT_FAILURE,
+					    "%s: more than one string pool",
+					    dbname);
+				if (_ti_loadpool(&pool, data, len) == -1)
+					err(EXIT_FAILURE, "_ti_loadpool");
+				odb_pool = id;
+			} else
+				odb_ids[id] = 0;
+			continue;
+		case TERMINFO_RTYPE_POOLED:
+			if (record_ref(data, len) >= odb_entries)
+				break;
+			/* FALLTHROUGH */
+		default:
+			cap = record_name(data, len);
+			if (cap == NULL)
+				break;
+			if (!replaced(cap, argc, argv))
+				odb_ids[id] = 0;
+			continue;
+		}
+		warnx("%s: record %u is invalid, dropping it",
+		    dbname, (unsigned int)id);
+	}
+	for (id = 0; id < odb_entries; id++) {
+		if (cdbr_get(odb, id, &data, &len))
+			err(EXIT_FAILURE, "cdbr_get");
+		if (len == 0 || *(const char *)data != TERMINFO_ALIAS)
+			continue;
+		cap = record_name(data, len);
+		ref = record_ref(data, len);
+		if (cap != NULL && ref < odb_entries &&
+		    odb_ids[ref] != NO_ID && !replaced(cap, argc, argv))
+			odb_ids[id] = 0;
+	}
+
+	/* Kept records follow the new pool, if any. */
+	ref = pflag ? POOL_ID + 1 : 0;
+	for (id = 0; id < odb_entries; id++) {
+		if (odb_ids[id] != NO_ID)
+			odb_ids[id] = ref++;
+	}
+}
+
+/* Copy the kept records of the database being updated into db. */
+static void
+copy_database(struct cdbw *db)
+{
+	const void *data;
+	const char *name;
+	char *buf, *cap;
+	size_t len;
+	uint32_t id, ref, nid;
+
+	for (id = 0; id < odb_entries; id++) {
+		if (odb_ids[id] == NO_ID)
+			continue;
+		if (cdbr_get(odb, id, &data, &len))
+			err(EXIT_FAILURE, "cdbr_get");
+		buf = malloc(len);
+		if (buf == NULL)
+			err(EXIT_FAILURE, NULL);
+		memcpy(buf, data, len);
+		ref = record_ref(buf, len);
+		if (ref != NO_ID) {
+			cap = buf + 1;
+			_ti_encode_32(&cap,
+			    ref == odb_pool ? POOL_ID : odb_ids[ref]);
+		}
+		if (cdbw_put_data(db, buf, len, &nid))
+			err(EXIT_FAILURE, "cdbw_put_data");
+		if (nid != odb_ids[id])
+			errx(EXIT_FAILURE, "record %u has id %u, expected %u",
+			    (unsigned int)id, (unsigned int)nid,
+			    (unsigned int)odb_ids[id]);
+		name = record_name(buf, len);
+		if (name != NULL &&
+		    cdbw_put_key(db, name, strlen(name) + 1, nid))
+			err(EXIT_FAILURE, "cdbw_put_key");
+		free(buf);
+	}
+	cdbr_close(odb);
+	odb = NULL;
+	free(odb_ids);
+	odb_ids = NULL;
+}
+
+/*
+ * Try the seed of the database being updated first, as its graph is
+ * likely to still be acyclic, then count up as the stable seeder does.
+ */
+static uint32_t
+update_seeder(void)
+{
+	static bool tried;
+	static uint32_t seed;
+
+	if (!tried) {
+		tried = true;
+		if (odb_seed != 0)
+			return odb_seed;
+	}
+	if (++seed == odb_seed)
+		++seed;
+	return seed;
+}
+
 static void
 write_database(const char *dbname, int argc, char **argv)
 {
 	struct cdbw *db;
 	char *tmp_dbname;
 	TERM *term;
+	uint32_t id;
 	int fd, i;
 
 	db = cdbw_open();
 	if (db == NULL)
 		err(EXIT_FAILURE, "cdbw_open failed");
-	/* Save the terms */
+	cdbw_set_fingerprints(db, 1);
+	if (uflag)
+		read_database(dbname, argc, argv);
+	/* Flatten the terms, filling the string pool */
 	if (argc > 0) {
 		for (i = 0; i < argc; i++) {
 			term = find_newest_term(argv[i]);
@@ -600,7 +1206,31 @@ write_database(const char *dbname, int argc, char **argv)
 				    argv[i]);
 				continue;
 			}
-			save_term(db, term);
+			if (term->base_term == NULL && term->data == NULL)
+				flatten_term(term);
+		}
+	} else
+		flatten_terms();
+	if (pflag) {
+		if (pool.buf.bufpos == 0) {
+			grow_tbuf(&pool.buf, 1);
+			pool.buf.buf[pool.buf.bufpos++] = TERMINFO_POOL;
+		}
+		if (cdbw_put_data(db, pool.buf.buf, pool.buf.bufpos, &id))
+			err(EXIT_FAILURE, "cdbw_put_data");
+		if (id != POOL_ID)
+			errx(EXIT_FAILURE, "string pool has id %u",
+			    (unsigned int)id);
+		_ti_freepool(&pool);
+	}
+	if (odb != NULL)
+		copy_database(db);
+	/* Save the terms */
+	if (argc > 0) {
+		for (i = 0; i < argc; i++) {
+			term = find_newest_term(argv[i]);
+			if (term != NULL)
+				save_term(db, term);
 		}
 	} else {
 		STAILQ_FOREACH(term, &terms, next)
@@ -615,7 +1245,8 @@ write_database(const char *dbname, int argc, char **argv)
 	if (fd == -1)
 		err(EXIT_FAILURE,
 		    "creating temporary database %s failed", tmp_dbname);
-	if (cdbw_output(db, fd, "NetBSD terminfo", cdbw_stable_seeder))
+	if (cdbw_output(db, fd, "NetBSD terminfo",
+	    uflag ? update_seeder : cdbw_stable_seeder))
 		err(EXIT_FAILURE,
 		    "writing temporary database %s failed", tmp_dbname);
 	if (fchmod(fd, 0666))
@@ -633,17 +1264,23 @@ int
 main(int argc, char **argv)
 {
 	int ch, cflag, sflag, flags;
+	char *ep;
 	char *source, *dbname, *buf, *ofile;
 	FILE *f;
 	size_t buflen;
 	ssize_t len;
 	TBUF tbuf;
 	struct term *term;
+	bool nonl;
 
 	cflag = sflag = 0;
+	nonl = false;
 	ofile = NULL;
 	flags = TIC_ALIAS | TIC_DESCRIPTION | TIC_WARNING;
-	while ((ch = getopt(argc, argv, "Saco:sx")) != -1)
+#ifdef _SC_NPROCESSORS_ONLN
+	njobs = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	while ((ch = getopt(argc, argv, "Sacj:o:psux")) != -1)
 	    switch (ch) {
 	    case 'S':
 		    Sflag = 1;
@@ -657,18 +1294,32 @@ main(int argc, char **argv)
 	    case 'c':
 		    cflag = 1;
 		    break;
+	    case 'j':
+		    errno = 0;
+		    njobs = strtol(optarg, &ep, 10);
+		    if (*optarg == '\0' || *ep != '\0' || errno != 0 ||
+			njobs < 1)
+			    errx(EXIT_FAILURE, "invalid jobs: %s", optarg);
+		    break;
 	    case 'o':
 		    ofile = optarg;
 		    break;
+	    case 'p':
+		    pflag = 1;
+		    break;
 	    case 's':
 		    sflag = 1;
 		    break;
+	    case 'u':
+		    uflag = 1;
+		    break;
 	    case 'x':
 		    flags |= TIC_EXTRA;
 		    break;
 	    case '?': /* FALLTHROUGH */
 	    default:
-		    fprintf(stderr, "usage: %s [-acSsx] [-o file] source\n",
+		    fprintf(stderr,
+			"usage: %s [-acpSsux] [-j jobs] [-o file] source\n",
 			argv[0] ? argv[0] : "tic");
 		    return EXIT_FAILURE;
 	    }
@@ -689,17 +1340,24 @@ main(int argc, char **argv)
 		if (*buf == '#')
 			continue;
 		if (buf[len - 1] != '\n') {
-			process_entry(&tbuf, flags);
-			dowarn("last line is not a comment"
-			    " and does not end with a newline");
+			if (njobs > 1)
+				add_span(&tbuf);
+			else
+				process_entry(&tbuf, flags);
+			/* warn once the entries before it are done */
+			nonl = true;
 			continue;
 		}
 		/*
 		 * If the first char is space not a space then we have a
 		 * new entry, so process it.
 		 */
-		if (!isspace((unsigned char)*buf) && tbuf.bufpos != 0)
-			process_entry(&tbuf, flags);
+		if (!isspace((unsigned char)*buf) && tbuf.bufpos != 0) {
+			if (njobs > 1)
+				add_span(&tbuf);
+			else
+				process_entry(&tbuf, flags);
+		}
 
 		/* Grow the buffer if needed */
 		grow_tbuf(&tbuf, len);
@@ -709,12 +1367,23 @@ main(int argc, char **argv)
 	}
 	free(buf);
 	/* Process the last entry if not done already */
-	process_entry(&tbuf, flags);
+	if (njobs > 1) {
+		add_span(&tbuf);
+		process_spans(flags);
+	} else
+		process_entry(&tbuf, flags);
 	free(tbuf.buf);
+	if (nonl)
+		dowarn("last line is not a comment"
+		    " and does not end with a newline");
 
-	/* Merge use entries until we have merged all we can */
-	while (merge_use(flags) != 0)
-		;
+	/* Merge use entries, each term after the terms it uses.
+	 * Promoted terms are appended to the list and resolved in turn. */
+	STAILQ_FOREACH(term, &terms, next) {
+		if (term->base_term == NULL)
+			resolve_use(term, flags);
+	}
+	free(use_stack);
 
 	if (Sflag) {
 		if (ofile && !freopen(ofile, "w", stdout))